@@ -0,0 +1,42 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/test/BitPlanes_test.cpp" "CMakeFiles/run_tests.dir/test/BitPlanes_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/BitPlanes_test.cpp.o.d"
+  "/root/repo/test/BootstrapArena_test.cpp" "CMakeFiles/run_tests.dir/test/BootstrapArena_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/BootstrapArena_test.cpp.o.d"
+  "/root/repo/test/CudaMI_test.cpp" "CMakeFiles/run_tests.dir/test/CudaMI_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/CudaMI_test.cpp.o.d"
+  "/root/repo/test/FFT_test.cpp" "CMakeFiles/run_tests.dir/test/FFT_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/FFT_test.cpp.o.d"
+  "/root/repo/test/Histogram1d_test.cpp" "CMakeFiles/run_tests.dir/test/Histogram1d_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/Histogram1d_test.cpp.o.d"
+  "/root/repo/test/Histogram2d_test.cpp" "CMakeFiles/run_tests.dir/test/Histogram2d_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/Histogram2d_test.cpp.o.d"
+  "/root/repo/test/NLogNTable_test.cpp" "CMakeFiles/run_tests.dir/test/NLogNTable_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/NLogNTable_test.cpp.o.d"
+  "/root/repo/test/ShiftedMutualInformationStream_test.cpp" "CMakeFiles/run_tests.dir/test/ShiftedMutualInformationStream_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/ShiftedMutualInformationStream_test.cpp.o.d"
+  "/root/repo/test/SimpleBinaryFile_test.cpp" "CMakeFiles/run_tests.dir/test/SimpleBinaryFile_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/SimpleBinaryFile_test.cpp.o.d"
+  "/root/repo/test/SimpleCSV_test.cpp" "CMakeFiles/run_tests.dir/test/SimpleCSV_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/SimpleCSV_test.cpp.o.d"
+  "/root/repo/test/all_pairs_test.cpp" "CMakeFiles/run_tests.dir/test/all_pairs_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/all_pairs_test.cpp.o.d"
+  "/root/repo/test/batch_test.cpp" "CMakeFiles/run_tests.dir/test/batch_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/batch_test.cpp.o.d"
+  "/root/repo/test/bias_correction_test.cpp" "CMakeFiles/run_tests.dir/test/bias_correction_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/bias_correction_test.cpp.o.d"
+  "/root/repo/test/bootstrap_mode_test.cpp" "CMakeFiles/run_tests.dir/test/bootstrap_mode_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/bootstrap_mode_test.cpp.o.d"
+  "/root/repo/test/bootstrap_rng_test.cpp" "CMakeFiles/run_tests.dir/test/bootstrap_rng_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/bootstrap_rng_test.cpp.o.d"
+  "/root/repo/test/histogram_kernels_test.cpp" "CMakeFiles/run_tests.dir/test/histogram_kernels_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/histogram_kernels_test.cpp.o.d"
+  "/root/repo/test/information_measures_test.cpp" "CMakeFiles/run_tests.dir/test/information_measures_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/information_measures_test.cpp.o.d"
+  "/root/repo/test/lag_search_test.cpp" "CMakeFiles/run_tests.dir/test/lag_search_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/lag_search_test.cpp.o.d"
+  "/root/repo/test/numa_placement_test.cpp" "CMakeFiles/run_tests.dir/test/numa_placement_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/numa_placement_test.cpp.o.d"
+  "/root/repo/test/one_to_many_test.cpp" "CMakeFiles/run_tests.dir/test/one_to_many_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/one_to_many_test.cpp.o.d"
+  "/root/repo/test/out_of_core_test.cpp" "CMakeFiles/run_tests.dir/test/out_of_core_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/out_of_core_test.cpp.o.d"
+  "/root/repo/test/shift_engines_test.cpp" "CMakeFiles/run_tests.dir/test/shift_engines_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/shift_engines_test.cpp.o.d"
+  "/root/repo/test/test_main.cpp" "CMakeFiles/run_tests.dir/test/test_main.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/test_main.cpp.o.d"
+  "/root/repo/test/utilities_test.cpp" "CMakeFiles/run_tests.dir/test/utilities_test.cpp.o" "gcc" "CMakeFiles/run_tests.dir/test/utilities_test.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
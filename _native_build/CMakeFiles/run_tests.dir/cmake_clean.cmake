@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/run_tests.dir/test/BitPlanes_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/BitPlanes_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/BootstrapArena_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/BootstrapArena_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/CudaMI_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/CudaMI_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/FFT_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/FFT_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/Histogram1d_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/Histogram1d_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/Histogram2d_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/Histogram2d_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/NLogNTable_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/NLogNTable_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/ShiftedMutualInformationStream_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/ShiftedMutualInformationStream_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/SimpleBinaryFile_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/SimpleBinaryFile_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/SimpleCSV_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/SimpleCSV_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/all_pairs_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/all_pairs_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/batch_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/batch_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/bias_correction_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/bias_correction_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/bootstrap_mode_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/bootstrap_mode_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/bootstrap_rng_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/bootstrap_rng_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/histogram_kernels_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/histogram_kernels_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/information_measures_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/information_measures_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/lag_search_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/lag_search_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/numa_placement_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/numa_placement_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/one_to_many_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/one_to_many_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/out_of_core_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/out_of_core_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/shift_engines_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/shift_engines_test.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/test_main.cpp.o"
+  "CMakeFiles/run_tests.dir/test/test_main.cpp.o.d"
+  "CMakeFiles/run_tests.dir/test/utilities_test.cpp.o"
+  "CMakeFiles/run_tests.dir/test/utilities_test.cpp.o.d"
+  "run_tests"
+  "run_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/run_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
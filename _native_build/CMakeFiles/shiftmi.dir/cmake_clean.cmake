@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/shiftmi.dir/main.cpp.o"
+  "CMakeFiles/shiftmi.dir/main.cpp.o.d"
+  "shiftmi"
+  "shiftmi.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/shiftmi.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -35,10 +35,16 @@ constexpr int default_bootstrap_reps    {100};
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <limits>
 #include <tclap/CmdLine.h>
 #include "src/SimpleCSV.h"
 #include "src/SimpleBinaryFile.h"
 #include "src/utilities.h"
+#include "src/out_of_core.h"
+#include "src/batch.h"
+#include "src/one_to_many.h"
+#include "src/lag_search.h"
+#include "src/information_measures.h"
 
 template<typename T, typename Iterator>
 inline T calc_mean(Iterator begin, Iterator end)
@@ -71,6 +77,22 @@ inline bool file_exists(const char* filename)
 	return fs.good();
 }
 
+inline unsigned long long parse_seed(const std::string& value)
+{
+	const bool digits = !value.empty() && std::all_of(value.begin(), value.end(),
+		[](const char c) { return c >= '0' && c <= '9'; });
+	try
+	{
+		if (digits)
+			return std::stoull(value);
+	}
+	catch (std::out_of_range&)
+	{
+	}
+	throw std::invalid_argument("seed must be an integer from 0 to " +
+		std::to_string(std::numeric_limits<unsigned long long>::max()) + ", not '" + value + "'.");
+}
+
 struct float_pair {
 	float first;
 	float second;
@@ -103,6 +125,66 @@ inline float_pair find_minmax_if_nan(float min, float max,
 	return result_pair;
 }
 
+/**
+ * Same as above but reads the file in chunks fitting into memory_budget bytes.
+ */
+inline float_pair find_minmax_if_nan(float min, float max,
+		ISimpleFile<float>& file, const std::size_t memory_budget) {
+	float_pair result_pair;
+	result_pair.first = min;
+	result_pair.second = max;
+	if (std::isnan(min) || std::isnan(max))
+	{
+		const std::size_t chunk_size = std::max(memory_budget / (sizeof(float) + sizeof(double)), std::size_t(1));
+		std::pair<float, float> minmax = find_minmax_chunked(file, chunk_size);
+		if (std::isnan(min))
+			result_pair.first = minmax.first;
+		if (std::isnan(max))
+			result_pair.second = minmax.second;
+	}
+	return result_pair;
+}
+
+/**
+ * Open path as CSV file if precision is 0, else as binary file.
+ */
+inline std::unique_ptr<ISimpleFile<float>> open_input(const std::string& path, const int precision, const char delim)
+{
+	if (precision == 0)
+		return std::unique_ptr<ISimpleFile<float>>(new SimpleCSV<float>(path, delim));
+	else
+		return std::unique_ptr<ISimpleFile<float>>(new SimpleBinaryFile<float>(path, static_cast<Precision>(precision)));
+}
+
+/**
+ * Print result to stdout if outfile_path is empty, else write it to a CSV or binary file (depending on the extension).
+ */
+inline void write_result(std::vector<float>& result, const std::string& outfile_path, const char delim)
+{
+	if (outfile_path.empty())
+	{
+		if (!result.empty())
+			std::cout << result[0];
+		for (std::size_t i = 1, max = result.size(); i < max; ++i)
+		{
+			std::cout << delim << result[i];
+		}
+		std::cout << std::endl;
+	}
+	else
+	{
+		if (outfile_path.size() > 4 && outfile_path.substr(outfile_path.size() - 4) == ".csv")
+		{
+			SimpleCSV<float> outputFile(outfile_path, delim);
+			outputFile.writeData(result);
+		} else
+		{
+			SimpleBinaryFile<float> outputFile(outfile_path, PREC_32);
+			outputFile.writeData(result);
+		}
+	}
+}
+
 int main(int argc, char* argv[])
 {
 	try
@@ -110,13 +192,37 @@ int main(int argc, char* argv[])
 		// Defining and parsing command line arguments with TCLAP (great library).
 		char desc[100]; // Use this for descriptions where default value need to be appended.
 		TCLAP::CmdLine cmd("Calculates mutual information by shifting over two data vectors.", ' ', "0.9");
-		TCLAP::UnlabeledValueArg<std::string> path1("path1", "first data vector", true, "", "path");
-		TCLAP::UnlabeledValueArg<std::string> path2("path2", "second data vector", true, "", "path");
+		TCLAP::UnlabeledValueArg<std::string> path1("path1", "first data vector (or the manifest with --batch)", true, "", "path");
+		TCLAP::UnlabeledValueArg<std::string> path2("path2", "second data vector (not used with --batch)", false, "", "path");
+		TCLAP::ValueArg<int> peaks("k", "peaks", "only search the k shifts with the largest local maxima by refining a coarse grid of "
+								   "shifts; the output are the k shifts followed by their values (default: 0 = evaluate all shifts)",
+								   false, 0, "int");
+		TCLAP::ValueArg<int> coarse_step("K", "coarse_step", "step of the coarse grid of shifts for --peaks "
+										 "(default: 0 = about 200 points)", false, 0, "int");
+		TCLAP::SwitchArg targets("T", "targets", "path2 is a text file listing one target file per line; each target is "
+								 "shifted against path1 and the results are one row per target", false);
+		TCLAP::SwitchArg batch("x", "batch", "path1 is a manifest with one pair of files per line, followed by options as key=value "
+							   "(shift_from, shift_to, shift_step, bins_x, bins_y, min1, max1, min2, max2, outfile) "
+							   "overriding the command line; results go to the outfile of each pair, or else "
+							   "all concatenated to --outfile, or else one line per pair to stdout", false);
 		TCLAP::SwitchArg bootstrapping("b", "bootstrapping", "Use bootstrapping for histograms", false);
 		sprintf(desc, "Number of sampled histograms for bootstrapping (default: %d)", default_bootstrap_samples);
 		TCLAP::ValueArg<int> bootstrapping_samples("B", "samples", desc, false, default_bootstrap_samples, "int");
 		sprintf(desc, "Repeat bootstrapping R times for mean and std. derivation (default: %d)", default_bootstrap_reps);
 		TCLAP::ValueArg<int> bootstrapping_reps("R", "repetitions", desc, false, default_bootstrap_reps, "int");
+		std::vector<std::string> rng_names = bootstrap_rng_names();
+		TCLAP::ValuesConstraint<std::string> rng_constraint(rng_names);
+		TCLAP::ValueArg<std::string> rng("r", "rng", "random number generator for bootstrapping (default: xoshiro256pp)",
+										 false, "xoshiro256pp", &rng_constraint);
+		std::vector<std::string> mode_names = bootstrap_mode_names();
+		TCLAP::ValuesConstraint<std::string> mode_constraint(mode_names);
+		TCLAP::ValueArg<std::string> bootstrap_mode("A", "bootstrap_mode", "draw each repetition from sampled histograms, or "
+													"from the multinomial of the joint histogram at a cost independent of the "
+													"number of samples (default: histograms)", false, "histograms", &mode_constraint);
+		// A string since not every build of TCLAP supports unsigned long long.
+		TCLAP::ValueArg<std::string> seed("S", "seed", "seed for bootstrapping; the same seed gives the same "
+										  "values of a shift on any number of threads (default: from the clock)",
+										  false, "", "int");
 		sprintf(desc, "minimum shift of second data vector against first one; can be negative (default: %d)", default_shift_from);
 		TCLAP::ValueArg<int> shift_from("f", "shift_from", desc, false, default_shift_from, "int");
 		sprintf(desc, "maximum shift of second data vector against first one; can be negative (default: %d)", default_shift_to);
@@ -133,6 +239,26 @@ int main(int argc, char* argv[])
 		TCLAP::ValueArg<float> max2("M", "max2", "maximum value to consider in second data vector (optional)", false, NAN, "float");
 		TCLAP::ValueArg<char> delimiter("d", "delimiter", "delimiter between values in csv files (default: space)", false, ' ', "char");
 		TCLAP::ValueArg<std::string> outfile("o", "outfile", "Results are written to outfile.bin or outfile.csv (default: stdout)", false, "", "string");
+		std::vector<std::string> engine_names = shift_engine_names();
+		TCLAP::ValuesConstraint<std::string> engine_constraint(engine_names);
+		TCLAP::ValueArg<std::string> engine("e", "engine", "strategy for calculating the histograms of all shifts (default: auto)",
+											false, "auto", &engine_constraint);
+		std::vector<std::string> numa_names = numa_policy_names();
+		TCLAP::ValuesConstraint<std::string> numa_constraint(numa_names);
+		TCLAP::ValueArg<std::string> numa("u", "numa", "placement of the data on NUMA systems; needs libnuma (default: none)",
+										  false, "none", &numa_constraint);
+		std::vector<std::string> bias_names = bias_correction_names();
+		TCLAP::ValuesConstraint<std::string> bias_constraint(bias_names);
+		TCLAP::ValueArg<std::string> bias("C", "correction", "subtract an analytical estimate of the bias from the mutual "
+										  "information; much cheaper than bootstrapping (default: none)",
+										  false, "none", &bias_constraint);
+		TCLAP::SwitchArg with_raw("W", "with_raw", "output the uncorrected values after the corrected ones", false);
+		std::vector<std::string> measure_names = information_measure_names();
+		TCLAP::ValuesConstraint<std::string> measure_constraint(measure_names);
+		TCLAP::MultiArg<std::string> measures("i", "measure", "also output this measure of every shift after the mutual "
+											  "information; can be given multiple times", false, &measure_constraint);
+		TCLAP::ValueArg<int> memory_budget("g", "memory_budget", "read the files in chunks using about this many MiB of memory "
+										   "instead of loading them completely (default: 0 = load completely)", false, 0, "int");
 		TCLAP::ValueArg<int> input_precision("p", "in_presicion", "Precision of input file, can be 0 (CSV, default), 32 (float), 64 (double)",
 										     false, 0, "int");
 		cmd.add(path1);
@@ -140,6 +266,12 @@ int main(int argc, char* argv[])
 		cmd.add(delimiter);
 		cmd.add(input_precision);
 		cmd.add(outfile);
+		cmd.add(engine);
+		cmd.add(numa);
+		cmd.add(memory_budget);
+		cmd.add(bias);
+		cmd.add(with_raw);
+		cmd.add(measures);
 		cmd.add(max2);
 		cmd.add(min2);
 		cmd.add(max1);
@@ -149,33 +281,146 @@ int main(int argc, char* argv[])
 		cmd.add(shift_step);
 		cmd.add(shift_to);
 		cmd.add(shift_from);
+		cmd.add(bootstrap_mode);
+		cmd.add(seed);
+		cmd.add(rng);
 		cmd.add(bootstrapping_reps);
 		cmd.add(bootstrapping_samples);
 		cmd.add(bootstrapping);
+		cmd.add(batch);
+		cmd.add(targets);
+		cmd.add(peaks);
+		cmd.add(coarse_step);
 		// Parse command line arguments and do stuff accordingly.
 		cmd.parse(argc, argv);
-		std::unique_ptr<ISimpleFile<float>> input1;
-		std::unique_ptr<ISimpleFile<float>> input2;
 		int precision = input_precision.getValue();
 		char delim = delimiter.getValue();
-		if (precision == 0)
+		const BiasCorrection correction = bias_correction_from_name(bias.getValue());
+		if ((correction != BIAS_NONE || with_raw.getValue() || !measures.getValue().empty())
+				&& (batch.getValue() || targets.getValue()
+				|| bootstrapping.getValue() || memory_budget.getValue() != 0 || peaks.getValue() != 0))
+			throw std::logic_error("Bias correction and measures can not be used with batch, targets, "
+				"bootstrapping, memory_budget or peaks.");
+		if ((numa.getValue() != "none" || engine.getValue() != "auto") && (batch.getValue() || targets.getValue()
+				|| bootstrapping.getValue() || memory_budget.getValue() != 0))
+			throw std::logic_error("numa and engine can not be used with batch, targets, bootstrapping or memory_budget.");
+		if (batch.getValue())
 		{
-			input1 = std::unique_ptr<ISimpleFile<float>>(new SimpleCSV<float>(path1.getValue(), delim));
-			input2 = std::unique_ptr<ISimpleFile<float>>(new SimpleCSV<float>(path2.getValue(), delim));
+			if (bootstrapping.getValue() || memory_budget.getValue() != 0)
+				throw std::logic_error("Bootstrapping and memory_budget can not be used with batch.");
+			BatchPair<float> defaults {"", "", shift_from.getValue(), shift_to.getValue(), shift_step.getValue(),
+				bins_x.getValue(), bins_y.getValue(), min1.getValue(), max1.getValue(), min2.getValue(), max2.getValue(), "", 0};
+			std::vector<BatchPair<float>> pairs = read_batch_manifest(path1.getValue(), defaults);
+			std::vector<std::vector<float>> results = batch_shifted_mutual_information(pairs,
+				[precision, delim](const std::string& path) { return open_input(path, precision, delim)->getData(); });
+			if (!outfile.getValue().empty())
+			{
+				std::vector<float> combined;
+				for (const std::vector<float>& result : results)
+				{
+					combined.insert(combined.end(), result.begin(), result.end());
+				}
+				write_result(combined, outfile.getValue(), delim);
+			}
+			else
+			{
+				for (std::size_t p = 0; p < pairs.size(); ++p)
+				{
+					write_result(results[p], pairs[p].outfile, delim);
+				}
+			}
+			return EXIT_SUCCESS;
 		}
-		else
+		if (path2.getValue().empty())
+			throw std::logic_error("path2 is needed without batch.");
+		std::unique_ptr<ISimpleFile<float>> input1 = open_input(path1.getValue(), precision, delim);
+		if (targets.getValue())
 		{
-			Precision prec = static_cast<Precision>(precision);
-			input1 = std::unique_ptr<ISimpleFile<float>>(new SimpleBinaryFile<float>(path1.getValue(), prec));
-			input2 = std::unique_ptr<ISimpleFile<float>>(new SimpleBinaryFile<float>(path2.getValue(), prec));
+			if (bootstrapping.getValue() || memory_budget.getValue() != 0)
+				throw std::logic_error("Bootstrapping and memory_budget can not be used with targets.");
+			std::vector<std::string> target_paths;
+			std::ifstream list(path2.getValue());
+			if (!list.is_open())
+				throw std::runtime_error("Could not open file: " + path2.getValue());
+			for (std::string line; std::getline(list, line);)
+			{
+				line.erase(0, line.find_first_not_of(" \t"));
+				line.erase(line.find_last_not_of(" \t\r") + 1);
+				if (!line.empty() && line[0] != '#')
+					target_paths.push_back(line);
+			}
+			if (target_paths.empty())
+				throw std::logic_error("There must be at least one target.");
+			float_pair minmax1 = find_minmax_if_nan(
+					min1.getValue(), max1.getValue(), input1->getData().begin(), input1->getData().end());
+			std::vector<float> result;
+			// The reference is binned once; the targets are loaded as they are binned.
+			one_to_many_shifted_mutual_information_streamed(
+				shift_from.getValue(), shift_to.getValue(),
+				bins_x.getValue(), bins_y.getValue(),
+				minmax1.first, minmax1.second,
+				input1->getData().begin(), input1->getData().end(),
+				target_paths.size(),
+				[&](const std::size_t t, float& minY, float& maxY) -> std::vector<float>
+				{
+					std::vector<float> data = open_input(target_paths[t], precision, delim)->getData();
+					float_pair minmax2 = find_minmax_if_nan(min2.getValue(), max2.getValue(), data.begin(), data.end());
+					minY = minmax2.first;
+					maxY = minmax2.second;
+					return data;
+				},
+				[&](const std::size_t first, const std::size_t last, const float* rows)
+				{
+					const std::size_t nr_shifts = (shift_to.getValue() - shift_from.getValue()) / shift_step.getValue() + 1;
+					if (outfile.getValue().empty())
+					{
+						for (std::size_t t = first; t < last; ++t)
+						{
+							std::vector<float> row(rows + (t - first) * nr_shifts, rows + (t - first + 1) * nr_shifts);
+							write_result(row, "", delim);
+						}
+					}
+					else
+					{
+						result.insert(result.end(), rows, rows + (last - first) * nr_shifts);
+					}
+				},
+				shift_step.getValue());
+			if (!outfile.getValue().empty())
+				write_result(result, outfile.getValue(), delim);
+			return EXIT_SUCCESS;
 		}
-		float_pair minmax1 = find_minmax_if_nan(
-				min1.getValue(), max1.getValue(), input1->getData().begin(), input1->getData().end());
-		float_pair minmax2 = find_minmax_if_nan(
-				min2.getValue(), max2.getValue(), input2->getData().begin(), input2->getData().end());
+		std::unique_ptr<ISimpleFile<float>> input2 = open_input(path2.getValue(), precision, delim);
 		std::vector<float> result;
-		if (bootstrapping.getValue())
+		if (memory_budget.getValue() < 0)
+			throw std::invalid_argument("memory_budget must not be negative.");
+		const std::size_t budget = std::size_t(memory_budget.getValue()) * 1024 * 1024;
+		if (peaks.getValue() < 0)
+			throw std::invalid_argument("peaks must not be negative.");
+		if (peaks.getValue() > 0 && (bootstrapping.getValue() || budget > 0))
+			throw std::logic_error("Bootstrapping and memory_budget can not be used with peaks.");
+		if (peaks.getValue() > 0 && (shift_step.getValue() != default_shift_step || numa.getValue() != "none"))
+			throw std::logic_error("shift_step and numa can not be used with peaks; the search steps through "
+				"the shifts with coarse_step.");
+		if (budget > 0)
 		{
+			if (bootstrapping.getValue())
+				throw std::logic_error("Bootstrapping needs all data in memory and can not be used with memory_budget.");
+			float_pair minmax1 = find_minmax_if_nan(min1.getValue(), max1.getValue(), *input1, budget);
+			float_pair minmax2 = find_minmax_if_nan(min2.getValue(), max2.getValue(), *input2, budget);
+			result = shifted_mutual_information_chunked(*input1, *input2,
+				shift_from.getValue(), shift_to.getValue(),
+				bins_x.getValue(), bins_y.getValue(),
+				minmax1.first, minmax1.second,
+				minmax2.first, minmax2.second,
+				shift_step.getValue(), budget);
+		}
+		else if (bootstrapping.getValue())
+		{
+			float_pair minmax1 = find_minmax_if_nan(
+					min1.getValue(), max1.getValue(), input1->getData().begin(), input1->getData().end());
+			float_pair minmax2 = find_minmax_if_nan(
+					min2.getValue(), max2.getValue(), input2->getData().begin(), input2->getData().end());
 			// These are `nr_repetition` vectors of mutual information
 			auto whole_result = shifted_mutual_information_with_bootstrap(
 				shift_from.getValue(), shift_to.getValue(),
@@ -185,7 +430,10 @@ int main(int argc, char* argv[])
 				input1->getData().begin(), input1->getData().end(),
 				input2->getData().begin(), input2->getData().end(),
 				bootstrapping_samples.getValue(),
-				bootstrapping_reps.getValue(), shift_step.getValue());
+				bootstrapping_reps.getValue(), shift_step.getValue(),
+				bootstrap_rng_from_name(rng.getValue()),
+				seed.isSet() ? parse_seed(seed.getValue()) : clock_seed(),
+				bootstrap_mode_from_name(bootstrap_mode.getValue()));
 			result.resize(whole_result.size() * 2);
 			// Now take the mean over all repetitions:
 			for (int i = 0, end = whole_result.size(); i < end; ++i)
@@ -199,37 +447,55 @@ int main(int argc, char* argv[])
 		}
 		else
 		{
-			result = shifted_mutual_information(
-				shift_from.getValue(), shift_to.getValue(),
-				bins_x.getValue(), bins_y.getValue(),
-				minmax1.first, minmax1.second,
-				minmax2.first, minmax2.second,
-				input1->getData().begin(), input1->getData().end(),
-				input2->getData().begin(), input2->getData().end(),
-				shift_step.getValue());
-		}
-		std::string outfile_path = outfile.getValue();
-		if (outfile_path.empty())
-		{
-			std::cout << result[0];
-			for (std::size_t i = 1, max = result.size(); i < max; ++i)
+			float_pair minmax1 = find_minmax_if_nan(
+					min1.getValue(), max1.getValue(), input1->getData().begin(), input1->getData().end());
+			float_pair minmax2 = find_minmax_if_nan(
+					min2.getValue(), max2.getValue(), input2->getData().begin(), input2->getData().end());
+			if (numa.getValue() != "none" && numa_node_count() < 2)
+				std::cerr << "warning: NUMA is not available, ignoring --numa" << std::endl;
+			if (peaks.getValue() > 0)
 			{
-				std::cout << delim << result[i];
+				LagSearchResult<float> search = find_mutual_information_peaks(
+					shift_from.getValue(), shift_to.getValue(),
+					bins_x.getValue(), bins_y.getValue(),
+					minmax1.first, minmax1.second,
+					minmax2.first, minmax2.second,
+					input1->getData().begin(), input1->getData().end(),
+					input2->getData().begin(), input2->getData().end(),
+					peaks.getValue(), coarse_step.getValue(), shift_engine_from_name(engine.getValue()));
+				for (const LagPeak<float>& peak : search.peaks)
+				{
+					result.push_back(float(peak.shift));
+				}
+				for (const LagPeak<float>& peak : search.peaks)
+				{
+					result.push_back(peak.mutual_information);
+				}
 			}
-			std::cout << std::endl;
-		}
-		else
-		{
-			if (outfile_path.size() > 4 && outfile_path.substr(outfile_path.size() - 4) == ".csv")
-			{
-				SimpleCSV<float> outputFile(outfile_path, delim);
-				outputFile.writeData(result);
-			} else
+			else
 			{
-				SimpleBinaryFile<float> outputFile(outfile_path, PREC_32);
-				outputFile.writeData(result);
+				std::vector<float> raw;
+				std::vector<float> entropies;
+				result = shifted_mutual_information(
+					shift_from.getValue(), shift_to.getValue(),
+					bins_x.getValue(), bins_y.getValue(),
+					minmax1.first, minmax1.second,
+					minmax2.first, minmax2.second,
+					input1->getData().begin(), input1->getData().end(),
+					input2->getData().begin(), input2->getData().end(),
+					shift_step.getValue(), shift_engine_from_name(engine.getValue()),
+					numa_policy_from_name(numa.getValue()), correction, &raw,
+					measures.getValue().empty() ? nullptr : &entropies);
+				if (with_raw.getValue())
+					result.insert(result.end(), raw.begin(), raw.end());
+				for (const std::string& name : measures.getValue())
+				{
+					std::vector<float> values = information_measure(information_measure_from_name(name), raw, entropies);
+					result.insert(result.end(), values.begin(), values.end());
+				}
 			}
 		}
+		write_result(result, outfile.getValue(), delim);
 	}
 	catch (TCLAP::ArgException &e)
 	{
@@ -0,0 +1,21 @@
+function [ x, y ] = narrowIndices( x, y, binSizes )
+%NARROWINDICES Convert histogram indices to the narrowest integer type
+%fitting the number of bins (uint8, uint16 or int32).
+%   x        Histogram indices of the first data series.
+%   y        Histogram indices of the second data series.
+%   binSizes [x-axis y-axis] number of bins
+% The largest value of the chosen type is reserved for values outside of
+% the bin range. Indices greater or equal the number of bins (like the
+% NaN positions from calculateIndices) therefore stay out of range.
+nrBins = max(binSizes);
+if nrBins < intmax('uint8')
+    x = uint8(x);
+    y = uint8(y);
+elseif nrBins < intmax('uint16')
+    x = uint16(x);
+    y = uint16(y);
+else
+    x = int32(x);
+    y = int32(y);
+end
+end
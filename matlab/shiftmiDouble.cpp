@@ -17,6 +17,7 @@
 */
 
 #include <vector>
+#include <cstdint>
 #include "mex.h"
 #include "../src/utilities.h"
 
@@ -66,18 +67,16 @@ void mexFunction(int nlhs,              // Number of output (left-side) argument
         mexErrMsgIdAndTxt("modern_mutual_information:wrongDimensions", "minmax_values need to be a 1x4 matrix.");
     double* minmax = (double*)mxGetData(prhs[2]);
 
-    if (!mxIsInt32(prhs[3]))
-        mexErrMsgIdAndTxt("modern_mutual_information:notInt", "Input matrix must be type Int32.");
+    if (!mxIsUint8(prhs[3]) && !mxIsUint16(prhs[3]) && !mxIsInt32(prhs[3]))
+        mexErrMsgIdAndTxt("modern_mutual_information:notIndex", "Input matrix must be type UInt8, UInt16 or Int32.");
     if (mxGetM(prhs[3]) != 1)
         mexErrMsgIdAndTxt("modern_mutual_information:wrongDimensions", "Input matrix must be a row vector.");
-    int* dataX = (int*)mxGetData(prhs[3]);
     mwSize dataX_size = mxGetN(prhs[3]);
 
-    if (!mxIsInt32(prhs[4]))
-        mexErrMsgIdAndTxt("modern_mutual_information:notInt", "Input matrix must be type Int32.");
+    if (mxGetClassID(prhs[4]) != mxGetClassID(prhs[3]))
+        mexErrMsgIdAndTxt("modern_mutual_information:notIndex", "Both input matrices must be of the same type.");
     if (mxGetM(prhs[4]) != 1)
         mexErrMsgIdAndTxt("modern_mutual_information:wrongDimensions", "Input matrix must be a row vector.");
-    int* dataY = (int*)mxGetData(prhs[4]);
     mwSize dataY_size = mxGetN(prhs[4]);
 
 	if (dataX_size != dataY_size)
@@ -93,12 +92,39 @@ void mexFunction(int nlhs,              // Number of output (left-side) argument
     mwSize outputSize = (shift[1] - shift[0]) / shift_step + 1;
     plhs[0] = mxCreateNumericMatrix(1, outputSize, mxDOUBLE_CLASS, mxREAL);
     double* outMatrix = (double*)mxGetData(plhs[0]);
-    shifted_mutual_information(
-            shift[0], shift[1],
-            bin_sizes[0], bin_sizes[1],
-            minmax[0], minmax[1], minmax[2], minmax[3],
-            dataX, dataX + dataX_size,
-            dataY, dataY + dataY_size,
-            shift_step,
-            outMatrix);
+    // Indices are passed on in their original (preferably narrow) type.
+    const void* dataX = mxGetData(prhs[3]);
+    const void* dataY = mxGetData(prhs[4]);
+    switch (mxGetClassID(prhs[3]))
+    {
+    case mxUINT8_CLASS:
+        shifted_mutual_information(
+                shift[0], shift[1],
+                bin_sizes[0], bin_sizes[1],
+                minmax[0], minmax[1], minmax[2], minmax[3],
+                (const uint8_t*)dataX, (const uint8_t*)dataX + dataX_size,
+                (const uint8_t*)dataY, (const uint8_t*)dataY + dataY_size,
+                shift_step,
+                outMatrix);
+        break;
+    case mxUINT16_CLASS:
+        shifted_mutual_information(
+                shift[0], shift[1],
+                bin_sizes[0], bin_sizes[1],
+                minmax[0], minmax[1], minmax[2], minmax[3],
+                (const uint16_t*)dataX, (const uint16_t*)dataX + dataX_size,
+                (const uint16_t*)dataY, (const uint16_t*)dataY + dataY_size,
+                shift_step,
+                outMatrix);
+        break;
+    default:
+        shifted_mutual_information(
+                shift[0], shift[1],
+                bin_sizes[0], bin_sizes[1],
+                minmax[0], minmax[1], minmax[2], minmax[3],
+                (const int*)dataX, (const int*)dataX + dataX_size,
+                (const int*)dataY, (const int*)dataY + dataY_size,
+                shift_step,
+                outMatrix);
+    }
 }
@@ -11,8 +11,6 @@ function result = shiftmiFloatBootstrapWrapper( x, y, varargin )
 %   'nrSamples',   scaler           (default: 100)
 %   'shiftSteps',  scalar           (default: 100)
 %   'shiftSteps',  stepNumber       (default: 1)
-x = int32(x);
-y = int32(y);
 minmaxOfData = single([0 1 0 1]);  % This isn't considered but needs to be passed to the function below.
 p = inputParser;
 addParameter(p, 'shiftRange', [-500 500]);
@@ -23,6 +21,7 @@ addParameter(p, 'shiftSteps', 1);
 parse(p, varargin{:});
 shiftRange = int32(p.Results.shiftRange);
 binSizes = int32(p.Results.binSizes);
+[x, y] = narrowIndices(x, y, binSizes);
 nrSamples = int32(p.Results.nrSamples);
 nrRepetitions = int32(p.Results.nrRepetitions);
 shiftSteps = int32(p.Results.shiftSteps);
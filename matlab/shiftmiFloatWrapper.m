@@ -9,8 +9,6 @@ function result = shiftmiFloatWrapper( x, y, varargin )
 %   'shiftRange', [from to]         (default: [-500 500])
 %   'binSizes',   [x-axis y-axis]   (default: [10 10])
 %   'shiftSteps',  stepNumber       (default: 1)
-x = int32(x);
-y = int32(y);
 minmaxOfData = single([0 1 0 1]);  % This isn't considered but needs to be passed to the function below.
 p = inputParser;
 addParameter(p, 'shiftRange', [-500 500]);
@@ -19,6 +17,7 @@ addParameter(p, 'shiftSteps', 1);
 parse(p, varargin{:});
 shiftRange = int32(p.Results.shiftRange);
 binSizes = int32(p.Results.binSizes);
+[x, y] = narrowIndices(x, y, binSizes);
 shiftSteps = int32(p.Results.shiftSteps);
 result = shiftmiFloat(shiftRange, binSizes, minmaxOfData, x, y, shiftSteps);
 end
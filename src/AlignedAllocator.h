@@ -0,0 +1,103 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <malloc.h>
+#endif
+
+/**
+ * Minimal allocator for std::vector returning memory aligned to `Alignment` bytes
+ * (by default a cache line). This way contiguous histogram buffers always start
+ * at a cache line boundary and can be loaded with aligned vector instructions.
+ */
+template<typename T, std::size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+
+	template<typename U>
+	struct rebind
+	{
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	AlignedAllocator() {}
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(std::size_t n);
+
+	void deallocate(T* p, std::size_t);
+};
+
+template<typename T, typename U, std::size_t Alignment>
+inline bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+{
+	return true;
+}
+
+template<typename T, typename U, std::size_t Alignment>
+inline bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+{
+	return false;
+}
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename T, std::size_t Alignment>
+T* AlignedAllocator<T, Alignment>::allocate(std::size_t n)
+{
+	if (n == 0)
+		return nullptr;
+	void* p = nullptr;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+	p = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+	if (posix_memalign(&p, Alignment, n * sizeof(T)) != 0)
+		p = nullptr;
+#endif
+	if (!p)
+		throw std::bad_alloc();
+	return static_cast<T*>(p);
+}
+
+template<typename T, std::size_t Alignment>
+void AlignedAllocator<T, Alignment>::deallocate(T* p, std::size_t)
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
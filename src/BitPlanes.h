@@ -0,0 +1,157 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#include <immintrin.h>
+#endif
+#include "AlignedAllocator.h"
+
+/**
+ * Histogram indices stored as one bit vector per bin: bit k of the plane of `bin`
+ * is set if indices[k] == bin. Indices out of range are in no plane and all bits
+ * after the last index are zero.
+ * The joint count of two bins is then the popcount of the AND of their planes,
+ * which handles 64 samples per instruction (512 with AVX-512 VPOPCNTDQ).
+ */
+class BitPlanes
+{
+public:
+	template<typename Index>
+	BitPlanes(const int bins, const Index* indices, const std::size_t size);
+
+	int getBins() const;
+
+	/**
+	 * Number of 64-bit words per plane.
+	 */
+	std::size_t getWords() const;
+
+	/**
+	 * Get the plane of a bin.
+	 */
+	const std::uint64_t* operator[](const int bin) const;
+
+	/**
+	 * Write the words [first_word, first_word + nr_words) of the plane of `bin` shifted
+	 * by `shift` bits to `out`, i.e. bit k of the result is bit k - shift of the plane.
+	 * Bits shifted in from outside of the plane are zero.
+	 */
+	void shifted(const int bin, const long long shift,
+		const std::size_t first_word, const std::size_t nr_words, std::uint64_t* out) const;
+
+private:
+	int bins;
+	std::size_t words;
+	std::vector<std::uint64_t, AlignedAllocator<std::uint64_t>> planes;
+};
+
+/**
+ * Number of set bits of a 64-bit word.
+ */
+inline int popcount64(std::uint64_t v);
+
+/**
+ * Number of set bits of the AND of two arrays of 64-bit words.
+ */
+inline std::size_t and_popcount(const std::uint64_t* a, const std::uint64_t* b, const std::size_t words);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename Index>
+BitPlanes::BitPlanes(const int bins, const Index* indices, const std::size_t size)
+	: bins(bins), words((size + 63) / 64), planes(std::size_t(bins) * ((size + 63) / 64), 0)
+{
+	for (std::size_t k = 0; k < size; ++k)
+	{
+		if (std::size_t(indices[k]) < std::size_t(bins))
+			planes[std::size_t(indices[k]) * words + k / 64] |= std::uint64_t(1) << (k % 64);
+	}
+}
+
+inline int BitPlanes::getBins() const
+{
+	return bins;
+}
+
+inline std::size_t BitPlanes::getWords() const
+{
+	return words;
+}
+
+inline const std::uint64_t* BitPlanes::operator[](const int bin) const
+{
+	return planes.data() + std::size_t(bin) * words;
+}
+
+inline void BitPlanes::shifted(const int bin, const long long shift,
+	const std::size_t first_word, const std::size_t nr_words, std::uint64_t* out) const
+{
+	const std::uint64_t* plane = (*this)[bin];
+	// shift = 64 * q + r with 0 <= r < 64 (rounding towards negative infinity).
+	const long long q = shift >= 0 ? shift / 64 : -((63 - shift) / 64);
+	const int r = int(shift - 64 * q);
+	const long long n = words;
+	for (std::size_t j = 0; j < nr_words; ++j)
+	{
+		const long long src = (long long)(first_word + j) - q;
+		const std::uint64_t low = src >= 0 && src < n ? plane[src] : 0;
+		const std::uint64_t high = r != 0 && src >= 1 && src <= n ? plane[src - 1] >> (64 - r) : 0;
+		out[j] = (low << r) | high;
+	}
+}
+
+inline int popcount64(std::uint64_t v)
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__POPCNT__) || !(defined(__x86_64__) || defined(__i386__)))
+	// Only use the builtin if it maps to an instruction; on x86 without -mpopcnt it is a library call.
+	return __builtin_popcountll(v);
+#else
+	v = v - ((v >> 1) & 0x5555555555555555ull);
+	v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+	return int((((v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full) * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+inline std::size_t and_popcount(const std::uint64_t* a, const std::uint64_t* b, const std::size_t words)
+{
+	std::size_t count = 0;
+	std::size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+	__m512i sum = _mm512_setzero_si512();
+	for (; i + 8 <= words; i += 8)
+	{
+		const __m512i v = _mm512_and_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+		sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(v));
+	}
+	count = std::size_t(_mm512_reduce_add_epi64(sum));
+#endif
+	for (; i < words; ++i)
+	{
+		count += popcount64(a[i] & b[i]);
+	}
+	return count;
+}
@@ -0,0 +1,225 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "AlignedAllocator.h"
+#include "histogram_kernels.h"
+
+/**
+ * Contiguous storage for the sampled sub-histograms of the bootstrap: nr_samples flat,
+ * row-major histograms of binsX * binsY counters one after the other, the histograms
+ * summing up a block of repetitions, the marginals and the scratch buffer of the histogram kernels.
+ * Every thread keeps one arena for all of its shifts. It only grows, so after the
+ * first shift there are no more allocations (and no page faults).
+ */
+template<typename Count>
+class BootstrapArena
+{
+public:
+	BootstrapArena();
+
+	/**
+	 * Make room for nr_samples histograms of binsX x binsY bins plus nr_totals
+	 * histograms for the repetitions and set all of them to zero.
+	 */
+	void reset(const int nr_samples, const int binsX, const int binsY, const int nr_totals = 1);
+
+	/**
+	 * Get the counters of a sampled histogram.
+	 */
+	Count* sample(const int index);
+
+	/**
+	 * Get the counters of the sum of the sampled histograms of a repetition.
+	 * The totals follow each other like the samples.
+	 */
+	Count* total(const int index = 0);
+
+	/**
+	 * Buffers of size binsX and binsY for the marginals of a total.
+	 */
+	Count* marginalX();
+	Count* marginalY();
+
+	/**
+	 * Scratch buffer for increment_histogram_2d.
+	 */
+	int* scratch();
+
+	/**
+	 * Number of counters the arena holds (which never shrinks).
+	 */
+	std::size_t getCapacity() const;
+
+private:
+	std::size_t cells;
+	int nr_samples;
+	int nr_totals;
+	int binsX;
+	// Sampled histograms followed by the totals and the marginals of X and Y.
+	std::vector<Count, AlignedAllocator<Count>> counts;
+	std::vector<int, AlignedAllocator<int>> scratch_buffer;
+};
+
+/**
+ * Sum up weighted histograms for many rows of weights at once: the matrix product
+ * output = weights * histograms with weights of size rows x nr_histograms and
+ * histograms and output holding flat histograms of size cells one after the other.
+ * In the bootstrap the weights are the multiplicities of the sampled histograms in
+ * the repetitions. The product is blocked over the cells so the rows of output being
+ * summed up stay in the L1 cache, and every histogram block loaded is used for
+ * combine_histograms_rows rows of output. The innermost loop is a vectorized
+ * multiply-add over consecutive cells.
+ */
+template<typename Count>
+void combine_histograms(const int* weights, const int rows,
+		const Count* histograms, const int nr_histograms,
+		const std::size_t cells, Count* output);
+
+/**
+ * Number of rows of output combine_histograms sums up together.
+ */
+constexpr int combine_histograms_rows {4};
+
+/**
+ * Number of cells per block of combine_histograms.
+ */
+constexpr std::size_t combine_histograms_cells {512};
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename Count>
+BootstrapArena<Count>::BootstrapArena()
+	: cells(0), nr_samples(0), nr_totals(0), binsX(0)
+{
+}
+
+template<typename Count>
+void BootstrapArena<Count>::reset(const int nr_samples, const int binsX, const int binsY, const int nr_totals /* 1 */)
+{
+	this->cells = std::size_t(binsX) * binsY;
+	this->nr_samples = nr_samples;
+	this->nr_totals = nr_totals;
+	this->binsX = binsX;
+	const std::size_t size = (std::size_t(nr_samples) + nr_totals) * cells + binsX + binsY;
+	if (counts.size() < size)
+		counts.resize(size);
+	std::fill(counts.begin(), counts.begin() + size, 0);
+	const std::size_t scratch_size = histogram_kernel_scratch_size(binsX, binsY);
+	if (scratch_buffer.size() < scratch_size)
+		scratch_buffer.resize(scratch_size);
+}
+
+template<typename Count>
+Count* BootstrapArena<Count>::sample(const int index)
+{
+	return counts.data() + std::size_t(index) * cells;
+}
+
+template<typename Count>
+Count* BootstrapArena<Count>::total(const int index /* 0 */)
+{
+	return counts.data() + (std::size_t(nr_samples) + index) * cells;
+}
+
+template<typename Count>
+Count* BootstrapArena<Count>::marginalX()
+{
+	return total(nr_totals);
+}
+
+template<typename Count>
+Count* BootstrapArena<Count>::marginalY()
+{
+	return total(nr_totals) + binsX;
+}
+
+template<typename Count>
+int* BootstrapArena<Count>::scratch()
+{
+	return scratch_buffer.data();
+}
+
+template<typename Count>
+std::size_t BootstrapArena<Count>::getCapacity() const
+{
+	return counts.size();
+}
+
+template<typename Count>
+void combine_histograms(const int* weights, const int rows,
+		const Count* histograms, const int nr_histograms,
+		const std::size_t cells, Count* output)
+{
+	std::fill(output, output + std::size_t(rows) * cells, 0);
+	for (std::size_t first = 0; first < cells; first += combine_histograms_cells)
+	{
+		const std::size_t width = std::min(combine_histograms_cells, cells - first);
+		for (int r = 0; r < rows; r += combine_histograms_rows)
+		{
+			const int nr_rows = std::min(combine_histograms_rows, rows - r);
+			const int* w = weights + std::size_t(r) * nr_histograms;
+			Count* out = output + std::size_t(r) * cells + first;
+			for (int k = 0; k < nr_histograms; ++k)
+			{
+				const Count* h = histograms + std::size_t(k) * cells + first;
+				if (nr_rows == combine_histograms_rows)
+				{
+					const Count w0 = w[k];
+					const Count w1 = w[nr_histograms + k];
+					const Count w2 = w[2 * nr_histograms + k];
+					const Count w3 = w[3 * nr_histograms + k];
+					if ((w0 | w1 | w2 | w3) == 0)
+						continue;
+					Count* out0 = out;
+					Count* out1 = out + cells;
+					Count* out2 = out + 2 * cells;
+					Count* out3 = out + 3 * cells;
+					for (std::size_t c = 0; c < width; ++c)
+					{
+						const Count value = h[c];
+						out0[c] += w0 * value;
+						out1[c] += w1 * value;
+						out2[c] += w2 * value;
+						out3[c] += w3 * value;
+					}
+				}
+				else
+				{
+					for (int row = 0; row < nr_rows; ++row)
+					{
+						const Count weight = w[std::size_t(row) * nr_histograms + k];
+						if (weight == 0)
+							continue;
+						Count* o = out + std::size_t(row) * cells;
+						for (std::size_t c = 0; c < width; ++c)
+						{
+							o[c] += weight * h[c];
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,129 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <stdexcept>
+
+/**
+ * Iterative radix-2 fast Fourier transform of complex double vectors whose
+ * size is a power of two. The twiddle factors are computed once per size.
+ */
+class FFT
+{
+public:
+	/**
+	 * @param size Length of the transform; must be a power of two.
+	 */
+	explicit FFT(std::size_t size);
+
+	std::size_t size() const;
+
+	/**
+	 * Transform data in place.
+	 * @param inverse Use positive exponents. The result is not divided by size.
+	 */
+	void transform(std::complex<double>* data, bool inverse=false) const;
+
+	/**
+	 * Smallest power of two greater or equal n.
+	 */
+	static std::size_t next_power_of_two(std::size_t n);
+
+private:
+	const std::size_t n;
+	// Twiddle factors of all stages: the stage joining blocks of size h
+	// uses twiddles[h + j] = exp(-2 pi i j / 2h) for j in [0, h).
+	std::vector< std::complex<double> > twiddles;
+};
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline FFT::FFT(std::size_t size)
+	: n(size), twiddles(size > 1 ? size : 1)
+{
+	if (size == 0 || (size & (size - 1)) != 0)
+		throw std::invalid_argument("Size of FFT must be a power of two.");
+	const double pi = std::acos(-1.);
+	for (std::size_t h = 1; h < n; h *= 2)
+	{
+		for (std::size_t j = 0; j < h; ++j)
+		{
+			const double angle = -pi * double(j) / double(h);
+			twiddles[h + j] = std::complex<double>(std::cos(angle), std::sin(angle));
+		}
+	}
+}
+
+inline std::size_t FFT::size() const
+{
+	return n;
+}
+
+inline std::size_t FFT::next_power_of_two(std::size_t n)
+{
+	std::size_t p = 1;
+	while (p < n)
+		p *= 2;
+	return p;
+}
+
+inline void FFT::transform(std::complex<double>* data, bool inverse /* false */) const
+{
+	// Bit-reversal permutation.
+	for (std::size_t i = 1, j = 0; i < n; ++i)
+	{
+		std::size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(data[i], data[j]);
+	}
+	// Butterflies; products are written out explicitly since std::complex
+	// multiplication has to handle infinities and is much slower.
+	const double sign = inverse ? -1. : 1.;
+	for (std::size_t h = 1; h < n; h *= 2)
+	{
+		const std::complex<double>* w = twiddles.data() + h;
+		for (std::size_t block = 0; block < n; block += 2 * h)
+		{
+			std::complex<double>* a = data + block;
+			std::complex<double>* b = a + h;
+			for (std::size_t j = 0; j < h; ++j)
+			{
+				const double wr = w[j].real();
+				const double wi = sign * w[j].imag();
+				const double br = b[j].real() * wr - b[j].imag() * wi;
+				const double bi = b[j].real() * wi + b[j].imag() * wr;
+				const double ar = a[j].real();
+				const double ai = a[j].imag();
+				a[j] = std::complex<double>(ar + br, ai + bi);
+				b[j] = std::complex<double>(ar - br, ai - bi);
+			}
+		}
+	}
+}
@@ -25,8 +25,9 @@
 /**
  * A class for 1D-histogram calculation.
  * Usable for all integral types.
+ * @tparam Count Type of the bin counters; use long long for more than INT_MAX values. (default: int)
  */
-template<typename T>
+template<typename T, typename Count = int>
 	// requires Integral<T>
 class Histogram1d
 {
@@ -49,7 +50,7 @@ public:
 	 * @param count Total number of values in histogram.
 	 */
 	Histogram1d(int bins, T min, T max,
-			std::vector<int> H, int count);
+			std::vector<Count> H, Count count);
 
 	/**
 	 * Calculate the histogram single-threaded on the CPU.
@@ -77,12 +78,12 @@ public:
 	/**
 	 * Get total number of values inserted into histogram.
 	 */
-	int getCount() const;
+	Count getCount() const;
 
 	/**
 	 * Get reference to histogram vector.
 	 */
-	const std::vector<int>& getHistogram() const;
+	const std::vector<Count>& getHistogram() const;
 
 	/**
 	 * Get (supposed) maximum value of the data.
@@ -96,10 +97,10 @@ public:
 
 private:
 	const int bins;
-	int count;
+	Count count;
 	const T min;
 	const T max;
-	std::vector<int> H;
+	std::vector<Count> H;
 
 	/**
 	 * Transfer function for actually doing the insertion into H.
@@ -115,36 +116,36 @@ private:
 /// IMPLEMENTATION
 //////////////////
 
-template<typename T>
-Histogram1d<T>::Histogram1d(int bins, T min, T max)
+template<typename T, typename Count>
+Histogram1d<T, Count>::Histogram1d(int bins, T min, T max)
 	: bins(bins), count(0), min(min), max(max)
 {
 	check_constructor();
 	H.resize(bins, 0);
 }
 
-template<typename T>
-Histogram1d<T>::Histogram1d(int bins, T min, T max,
-	std::vector<int> H, int count)
+template<typename T, typename Count>
+Histogram1d<T, Count>::Histogram1d(int bins, T min, T max,
+	std::vector<Count> H, Count count)
 	: bins(bins), count(count), min(min), max(max), H(H)
 {
 	check_constructor();
 	// Casting bins to size_type because it can't be negative thanks to check_constructor method.
-	if (H.size() != std::vector<int>::size_type(bins))
+	if (H.size() != std::size_t(bins))
 		throw std::invalid_argument("Argument bins has to be of same size as H vector.");
 }
 
-template<typename T>
+template<typename T, typename Count>
 template<typename Iterator>
-void Histogram1d<T>::calculate_cpu(const Iterator begin, const Iterator end)
+void Histogram1d<T, Count>::calculate_cpu(const Iterator begin, const Iterator end)
 {
 	for (auto i = begin; i != end; ++i)
 		transfer(*i);
 }
 
-template<typename T>
+template<typename T, typename Count>
 template<typename Iterator>
-void Histogram1d<T>::increment_cpu(const Iterator begin, const Iterator end)
+void Histogram1d<T, Count>::increment_cpu(const Iterator begin, const Iterator end)
 {
 	for (auto index = begin; index != end; ++index)
 	{
@@ -156,38 +157,38 @@ void Histogram1d<T>::increment_cpu(const Iterator begin, const Iterator end)
 	}
 }
 
-template<typename T>
-int Histogram1d<T>::getBins() const
+template<typename T, typename Count>
+int Histogram1d<T, Count>::getBins() const
 {
 	return bins;
 }
 
-template<typename T>
-int Histogram1d<T>::getCount() const
+template<typename T, typename Count>
+Count Histogram1d<T, Count>::getCount() const
 {
 	return count;
 }
 
-template<typename T>
-const std::vector<int>& Histogram1d<T>::getHistogram() const
+template<typename T, typename Count>
+const std::vector<Count>& Histogram1d<T, Count>::getHistogram() const
 {
 	return H;
 }
 
-template<typename T>
-T Histogram1d<T>::getMax() const
+template<typename T, typename Count>
+T Histogram1d<T, Count>::getMax() const
 {
 	return max;
 }
 
-template<typename T>
-T Histogram1d<T>::getMin() const
+template<typename T, typename Count>
+T Histogram1d<T, Count>::getMin() const
 {
 	return min;
 }
 
-template<typename T>
-void Histogram1d<T>::transfer(const T value)
+template<typename T, typename Count>
+void Histogram1d<T, Count>::transfer(const T value)
 {
 	if (value >= min && value < max)
 	{
@@ -204,8 +205,8 @@ void Histogram1d<T>::transfer(const T value)
 	}
 }
 
-template<typename T>
-void Histogram1d<T>::check_constructor() const
+template<typename T, typename Count>
+void Histogram1d<T, Count>::check_constructor() const
 {
 	if (min >= max)
 		throw std::logic_error("min has to be smaller than max.");
@@ -22,17 +22,59 @@
 #include <cstddef>
 #include <utility>
 #include <memory>
-#include "utilities.h"
 #include <stdexcept>
 #include <iterator>
+#include <algorithm>
 #include <cmath>
 #include "Histogram1d.h"
+#include "AlignedAllocator.h"
+#include "histogram_kernels.h"
+#include "NLogNTable.h"
+#include "bias_correction.h"
+
+/**
+ * Read-only view of the contiguous, row-major bin counts of a Histogram2d.
+ * view[x][y] accesses the same bin as with the former nested vectors
+ * while begin() and end() iterate over all binsX * binsY counts.
+ * The view is only valid as long as the viewed histogram exists.
+ */
+template<typename Count>
+class BasicHistogram2dView
+{
+public:
+	BasicHistogram2dView(const Count* data, int binsX, int binsY)
+		: ptr(data), binsX(binsX), binsY(binsY) {}
+
+	/**
+	 * Get pointer to the binsY counts of row x.
+	 */
+	const Count* operator[](int x) const { return ptr + std::size_t(x) * binsY; }
+
+	const Count* data() const { return ptr; }
+	const Count* begin() const { return ptr; }
+	const Count* end() const { return ptr + size(); }
+	std::size_t size() const { return std::size_t(binsX) * binsY; }
+	int getBinsX() const { return binsX; }
+	int getBinsY() const { return binsY; }
+
+private:
+	const Count* ptr;
+	int binsX;
+	int binsY;
+};
+
+/**
+ * View of a histogram with the default int counts.
+ */
+typedef BasicHistogram2dView<int> Histogram2dView;
 
 /**
  * A class for 2D-histogram calculation.
  * Usable for all integral types.
+ * @tparam Count Type of the bin counters and the total count; int is enough for
+ *         up to INT_MAX values, otherwise use long long. (default: int)
  */
-template<typename T>
+template<typename T, typename Count = int>
 	// requires Integral<T>
 class Histogram2d
 {
@@ -88,6 +130,14 @@ public:
 	void increment_cpu(const Iterator beginX, const Iterator endX,
 					   const Iterator beginY, const Iterator endY);
 
+	/**
+	 * Same as above for contiguous arrays of indices. Increments are done by the
+	 * vectorized kernels with lane-private sub-histograms from histogram_kernels.h.
+	 */
+	template<typename Index>
+	void increment_cpu(const Index* beginX, const Index* endX,
+					   const Index* beginY, const Index* endY);
+
 	/**
 	 * Increment histogram at specified position by one.
 	 */
@@ -98,7 +148,14 @@ public:
 	 * indices are summed up. Histograms need to have same bin size.
 	 * @param histogram_to_add needs to have same bin size on both axes as original histogram.
 	 */
-	void add(const Histogram2d<T>& histogram_to_add);
+	void add(const Histogram2d<T, Count>& histogram_to_add);
+
+	/**
+	 * Set all bins and the total count back to zero so the same object (and its
+	 * memory) can be reused for another calculation.
+	 * Lazily calculated 1-D histograms and mutual information are discarded.
+	 */
+	void reset();
 
 	/**
 	 * Get bin count of x-axis as specified in constructor.
@@ -113,12 +170,12 @@ public:
 	/**
 	 * Get total number of values inserted into histogram.
 	 */
-	int getCount() const;
+	Count getCount() const;
 
 	/**
-	 * Get reference to histogram vector.
+	 * Get a view of the histogram's bin counts.
 	 */
-	const std::vector<std::vector<int>>& getHistogram() const;
+	BasicHistogram2dView<Count> getHistogram() const;
 
 	/**
 	 * Calculate two 1-D histograms from 2-D histogram.
@@ -127,7 +184,7 @@ public:
 	 * @param force Don't use lazy evaluation and force (re)calculation.
 	 * @return A pair of pointers to the corresponding Histogram1d classes.
 	 */
-	std::pair<const Histogram1d<T>*, const Histogram1d<T>*> reduce1d(bool force=false);
+	std::pair<const Histogram1d<T, Count>*, const Histogram1d<T, Count>*> reduce1d(bool force=false);
 
 	/**
 	 * Get (supposed) minimum value of the first data vector.
@@ -158,17 +215,34 @@ public:
 	 */
 	const T* calculate_mutual_information(bool force=false);
 
+	/**
+	 * Calculate mutual information minus an estimate of its bias (see mutual_information_bias).
+	 * The uncorrected value is cached like with calculate_mutual_information.
+	 * @param raw (Optional) Receives the uncorrected value.
+	 */
+	T calculate_corrected_mutual_information(const BiasCorrection correction, T* raw=nullptr);
+
+	/**
+	 * Calculate the entropies (in bits) of the marginal and joint distributions.
+	 * @param entropies Receives H(X), H(Y) and H(X,Y).
+	 */
+	void calculate_entropies(T* entropies);
+
 private:
 	const int binsX;
 	const int binsY;
-	int count;
+	Count count;
 	const T minX;
 	const T maxX;
 	const T minY;
 	const T maxY;
-	std::vector<std::vector<int>> H;
-	std::unique_ptr<Histogram1d<T>> hist1dX;
-	std::unique_ptr<Histogram1d<T>> hist1dY;
+	// Row-major bin counts: H[x * binsY + y]
+	std::vector<Count, AlignedAllocator<Count>> H;
+	// Sub-histograms for the increment kernels; allocated on first use.
+	// They always hold int counts since the kernels split larger inputs into blocks.
+	std::vector<int, AlignedAllocator<int>> scratch;
+	std::unique_ptr<Histogram1d<T, Count>> hist1dX;
+	std::unique_ptr<Histogram1d<T, Count>> hist1dY;
 	std::unique_ptr<T> mutual_information;
 
 	/**
@@ -185,20 +259,20 @@ private:
 /// IMPLEMENTATION
 //////////////////
 
-template<typename T>
-Histogram2d<T>::Histogram2d(int binsX, int binsY,
+template<typename T, typename Count>
+Histogram2d<T, Count>::Histogram2d(int binsX, int binsY,
 	T minX, T maxX,
 	T minY, T maxY)
 	: binsX(binsX), binsY(binsY), count(0), minX(minX), maxX(maxX),
 	minY(minY), maxY(maxY)
 {
 	check_constructor();
-	H.resize(binsX, std::vector<int>(binsY, 0));
+	H.resize(std::size_t(binsX) * binsY, 0);
 }
 
-template<typename T>
+template<typename T, typename Count>
 template<typename Iterator>
-void Histogram2d<T>::calculate_cpu(const Iterator beginX, const Iterator endX,
+void Histogram2d<T, Count>::calculate_cpu(const Iterator beginX, const Iterator endX,
 	const Iterator beginY, const Iterator endY)
 {
 	if (std::distance(beginX, endX) != std::distance(beginY, endY))
@@ -209,115 +283,137 @@ void Histogram2d<T>::calculate_cpu(const Iterator beginX, const Iterator endX,
 	}
 }
 
-template<typename T>
+template<typename T, typename Count>
 template<typename Iterator>
-void Histogram2d<T>::increment_cpu(const Iterator begin, const Iterator end)
+void Histogram2d<T, Count>::increment_cpu(const Iterator begin, const Iterator end)
 {
 	for (auto index = begin; index != end; ++index)
 	{
 		if (index->first  < binsX
 			&& index->second < binsY)
 		{
-			++H[index->first][index->second];
+			++H[index->first * binsY + index->second];
 			++count;
 		}
 	}
 }
 
-template<typename T>
+template<typename T, typename Count>
 template<typename Iterator>
-void Histogram2d<T>::increment_cpu(const Iterator beginX, const Iterator endX,
+void Histogram2d<T, Count>::increment_cpu(const Iterator beginX, const Iterator endX,
 	const Iterator beginY, const Iterator endY)
 {
 	if (std::distance(beginX, endX) != std::distance(beginY, endY))
 		throw std::logic_error("Containers referenced by iterators must have the same size.");
+	Count* h = H.data();
 	for (auto iX = beginX, iY = beginY; iX != endX; ++iX, ++iY)
 	{
 		if (*iX < binsX && *iY < binsY)
 		{
-			++H[*iX][*iY];
+			++h[*iX * binsY + *iY];
 			++count;
 		}
 	}
 }
 
-template<typename T>
-void Histogram2d<T>::increment_at(int iX, int iY)
+template<typename T, typename Count>
+template<typename Index>
+void Histogram2d<T, Count>::increment_cpu(const Index* beginX, const Index* endX,
+	const Index* beginY, const Index* endY)
+{
+	if (std::distance(beginX, endX) != std::distance(beginY, endY))
+		throw std::logic_error("Containers referenced by iterators must have the same size.");
+	std::size_t size = std::distance(beginX, endX);
+	if (histogram_kernel_use_lanes(binsX, binsY, size) && scratch.empty())
+		scratch.resize(histogram_kernel_scratch_size(binsX, binsY));
+	count += increment_histogram_2d(H.data(), binsX, binsY, beginX, beginY, size, scratch.data());
+}
+
+template<typename T, typename Count>
+void Histogram2d<T, Count>::increment_at(int iX, int iY)
 {
 	if (iX < binsX && iY < binsY)
 	{
-		++H[iX][iY];
+		++H[iX * binsY + iY];
 		++count;
 	}
 }
 
-template<typename T>
-void Histogram2d<T>::add(const Histogram2d<T>& histogram_to_add)
+template<typename T, typename Count>
+void Histogram2d<T, Count>::add(const Histogram2d<T, Count>& histogram_to_add)
 {
 	if (histogram_to_add.getBinsX() != binsX
 		|| histogram_to_add.getBinsY() != binsY)
 		throw std::logic_error("Unable to sum histograms with different bin size.");
-	auto h2 = histogram_to_add.getHistogram();
-	for (int x = 0; x < binsX; ++x)
+	Count* h = H.data();
+	const Count* h2 = histogram_to_add.H.data();
+	for (std::size_t i = 0, size = H.size(); i < size; ++i)
 	{
-		for (int y = 0; y < binsY; ++y)
-		{
-			H[x][y] += h2[x][y];
-		}
+		h[i] += h2[i];
 	}
 	count += histogram_to_add.getCount();
 }
 
-template<typename T>
-int Histogram2d<T>::getBinsX() const
+template<typename T, typename Count>
+void Histogram2d<T, Count>::reset()
+{
+	std::fill(H.begin(), H.end(), 0);
+	count = 0;
+	hist1dX.reset();
+	hist1dY.reset();
+	mutual_information.reset();
+}
+
+template<typename T, typename Count>
+int Histogram2d<T, Count>::getBinsX() const
 {
 	return binsX;
 }
 
-template<typename T>
-int Histogram2d<T>::getBinsY() const
+template<typename T, typename Count>
+int Histogram2d<T, Count>::getBinsY() const
 {
 	return binsY;
 }
 
-template<typename T>
-int Histogram2d<T>::getCount() const
+template<typename T, typename Count>
+Count Histogram2d<T, Count>::getCount() const
 {
 	return count;
 }
 
-template<typename T>
-const std::vector<std::vector<int> >& Histogram2d<T>::getHistogram() const
+template<typename T, typename Count>
+BasicHistogram2dView<Count> Histogram2d<T, Count>::getHistogram() const
 {
-	return H;
+	return BasicHistogram2dView<Count>(H.data(), binsX, binsY);
 }
 
-template<typename T>
-T Histogram2d<T>::getMinX() const
+template<typename T, typename Count>
+T Histogram2d<T, Count>::getMinX() const
 {
 	return minX;
 }
 
-template<typename T>
-T Histogram2d<T>::getMaxX() const
+template<typename T, typename Count>
+T Histogram2d<T, Count>::getMaxX() const
 {
 	return maxX;
 }
 
-template<typename T>
-T Histogram2d<T>::getMinY() const
+template<typename T, typename Count>
+T Histogram2d<T, Count>::getMinY() const
 {
 	return minY;
 }
 
-template<typename T>
-T Histogram2d<T>::getMaxY() const
+template<typename T, typename Count>
+T Histogram2d<T, Count>::getMaxY() const
 {
 	return maxY;
 }
 
-template<typename T>
-void Histogram2d<T>::transfer(const T x, const T y)
+template<typename T, typename Count>
+void Histogram2d<T, Count>::transfer(const T x, const T y)
 {
 	if (x >= minX
 		&& x <= maxX
@@ -336,34 +432,35 @@ void Histogram2d<T>::transfer(const T x, const T y)
 		else
 #pragma warning(suppress: 4244)
 			indexY = (y - minY) / (maxY - minY) * binsY;
-		++H[indexX][indexY];
+		++H[indexX * binsY + indexY];
 		++count;
 	}
 }
 
-template<typename T>
-std::pair<const Histogram1d<T>*, const Histogram1d<T>*> Histogram2d<T>::reduce1d(bool force /* false */)
+template<typename T, typename Count>
+std::pair<const Histogram1d<T, Count>*, const Histogram1d<T, Count>*> Histogram2d<T, Count>::reduce1d(bool force /* false */)
 {
 	if (force || !hist1dX || !hist1dY)
 	{
-		std::vector<int> vecX(binsX, 0);
-		std::vector<int> vecY(binsY, 0);
-		for (int x = 0; x < binsX; ++x)
+		std::vector<Count> vecX(binsX, 0);
+		std::vector<Count> vecY(binsY, 0);
+		const Count* row = H.data();
+		for (int x = 0; x < binsX; ++x, row += binsY)
 		{
 			for (int y = 0; y < binsY; ++y)
 			{
-				vecX[x] += H[x][y];
-				vecY[y] += H[x][y];
+				vecX[x] += row[y];
+				vecY[y] += row[y];
 			}
 		}
-		hist1dX.reset(new Histogram1d<T>(binsX, minX, maxX, vecX, count));
-		hist1dY.reset(new Histogram1d<T>(binsY, minY, maxY, vecY, count));
+		hist1dX.reset(new Histogram1d<T, Count>(binsX, minX, maxX, vecX, count));
+		hist1dY.reset(new Histogram1d<T, Count>(binsY, minY, maxY, vecY, count));
 	}
-	return std::pair<const Histogram1d<T>*, const Histogram1d<T>*>(hist1dX.get(), hist1dY.get());
+	return std::pair<const Histogram1d<T, Count>*, const Histogram1d<T, Count>*>(hist1dX.get(), hist1dY.get());
 }
 
-template<typename T>
-void Histogram2d<T>::check_constructor() const
+template<typename T, typename Count>
+void Histogram2d<T, Count>::check_constructor() const
 {
 	if (minX >= maxX)
 		throw std::logic_error("minX has to be smaller than maxX.");
@@ -375,27 +472,39 @@ void Histogram2d<T>::check_constructor() const
 		throw std::invalid_argument("There must be at least one binY.");
 }
 
-template <typename T>
-const T* Histogram2d<T>::calculate_mutual_information(bool force /* false */)
+template<typename T, typename Count>
+const T* Histogram2d<T, Count>::calculate_mutual_information(bool force /* false */)
 {
 	if (force || !mutual_information)
 	{
-		T mi = 0;
 		auto h = reduce1d(force);
-		for (int x = 0; x < binsX; ++x)
-		{
-			for (int y = 0; y < binsY; ++y)
-			{
-				if (H[x][y] > 0)
-				{
-					T p_xy = T(H[x][y]) / count;
-					T p_x = T(h.first->getHistogram()[x]) / count;
-					T p_y = T(h.second->getHistogram()[y]) / count;
-					mi += p_xy * std::log2(p_xy / (p_x * p_y));
-				}
-			}
-		}
+		const std::vector<Count>& hX = h.first->getHistogram();
+		const std::vector<Count>& hY = h.second->getHistogram();
+		T mi = mutual_information_from_counts<T>(H.data(), hX.data(), hY.data(), binsX, binsY, count);
 		mutual_information.reset(new T(mi));
 	}
 	return mutual_information.get();
+}
+
+template<typename T, typename Count>
+T Histogram2d<T, Count>::calculate_corrected_mutual_information(const BiasCorrection correction, T* raw /* nullptr */)
+{
+	const T mi = *calculate_mutual_information();
+	if (raw)
+		*raw = mi;
+	if (correction == BIAS_NONE)
+		return mi;
+	auto h = reduce1d();
+	const std::vector<Count>& hX = h.first->getHistogram();
+	const std::vector<Count>& hY = h.second->getHistogram();
+	return T(mi - mutual_information_bias(H.data(), hX.data(), hY.data(), binsX, binsY, count, correction));
+}
+
+template<typename T, typename Count>
+void Histogram2d<T, Count>::calculate_entropies(T* entropies)
+{
+	auto h = reduce1d();
+	entropies[0] = entropy_from_counts<T>(h.first->getHistogram().data(), binsX, count);
+	entropies[1] = entropy_from_counts<T>(h.second->getHistogram().data(), binsY, count);
+	entropies[2] = entropy_from_counts<T>(H.data(), H.size(), count);
 }
\ No newline at end of file
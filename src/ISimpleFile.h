@@ -20,6 +20,7 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 
 /**
  * Interface for reading and writing from/to files.
@@ -32,4 +33,16 @@ public:
     virtual ~ISimpleFile() {};
 	virtual std::vector<T>& getData() = 0;
 	virtual void writeData(const std::vector<T>& data_to_write) = 0;
+
+	/**
+	 * Read the file sequentially without keeping all of it in memory:
+	 * each call replaces the contents of chunk with the next (at most) max_values values.
+	 * @return Number of values read; 0 at the end of the file.
+	 */
+	virtual std::size_t readChunk(std::vector<T>& chunk, std::size_t max_values) = 0;
+
+	/**
+	 * Start reading chunks from the beginning of the file again.
+	 */
+	virtual void rewind() = 0;
 };
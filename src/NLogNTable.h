@@ -0,0 +1,254 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Lookup table for n * log2(n) with integer n, shared by all threads.
+ *
+ * Since histograms only hold integer counts, mutual information can be written as
+ * MI = (sum n_xy log2 n_xy - sum n_x log2 n_x - sum n_y log2 n_y) / N + log2 N
+ * which only needs n * log2(n) of joint and marginal counts and no divisions.
+ *
+ * The table grows lazily up to max_size entries. Growing allocates a new, larger table;
+ * older tables are kept alive so threads still reading them are not disturbed.
+ * Lookups therefore never need a lock.
+ */
+class NLogNTable
+{
+public:
+	/**
+	 * Largest number of entries the table will grow to.
+	 * Larger counts are calculated directly.
+	 */
+	static constexpr std::size_t max_size {std::size_t(1) << 20};
+
+	/**
+	 * Contiguous table for counts in [0, size).
+	 */
+	struct Snapshot
+	{
+		const double* data;
+		std::size_t size;
+	};
+
+	/**
+	 * Get the table shared by all threads.
+	 */
+	static NLogNTable& instance();
+
+	/**
+	 * Get a table holding at least all counts up to n (as long as n < max_size).
+	 * Grows the table if necessary.
+	 */
+	Snapshot reserve(std::size_t n);
+
+	/**
+	 * n * log2(n) for a single count; 0 for n = 0.
+	 */
+	static double nlogn(double n);
+
+private:
+	NLogNTable();
+	NLogNTable(const NLogNTable&) = delete;
+	NLogNTable& operator=(const NLogNTable&) = delete;
+
+	std::mutex mutex;
+	std::vector< std::unique_ptr<double[]> > tables;
+	std::vector< std::unique_ptr<Snapshot> > snapshots;
+	std::atomic<const Snapshot*> current;
+};
+
+/**
+ * Sum of n * log2(n) over all counts.
+ * @param table Snapshot of NLogNTable; counts not in the table are calculated directly.
+ */
+inline double sum_nlogn(const int* counts, const std::size_t size, const NLogNTable::Snapshot& table);
+
+/**
+ * Same as above for 64-bit counts.
+ */
+inline double sum_nlogn(const long long* counts, const std::size_t size, const NLogNTable::Snapshot& table);
+
+/**
+ * Calculate mutual information (in bits) from the integer counts of a histogram.
+ * @param H Row-major joint histogram of size binsX * binsY.
+ * @param hX Marginal histogram of size binsX (sums of the rows of H).
+ * @param hY Marginal histogram of size binsY (sums of the columns of H).
+ * @param count Total number of values in H.
+ * @tparam Count int or long long.
+ */
+template<typename T, typename Count>
+T mutual_information_from_counts(const Count* H, const Count* hX, const Count* hY,
+		const int binsX, const int binsY, const long long count);
+
+/**
+ * Calculate the entropy (in bits) of a histogram from its integer counts.
+ * @param count Total number of values in counts.
+ */
+template<typename T, typename Count>
+T entropy_from_counts(const Count* counts, const std::size_t size, const long long count);
+
+/**
+ * Like mutual_information_from_counts but the marginal histograms and the total
+ * are derived from the joint histogram H.
+ * @param hX Buffer of size binsX for the marginal histogram of X.
+ * @param hY Buffer of size binsY for the marginal histogram of Y.
+ */
+template<typename T, typename Count>
+T mutual_information_from_joint_counts(const Count* H, const int binsX, const int binsY, Count* hX, Count* hY);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline NLogNTable::NLogNTable()
+	: current(nullptr)
+{
+}
+
+inline NLogNTable& NLogNTable::instance()
+{
+	static NLogNTable table;
+	return table;
+}
+
+inline double NLogNTable::nlogn(double n)
+{
+	return n > 0 ? n * std::log2(n) : 0.;
+}
+
+inline NLogNTable::Snapshot NLogNTable::reserve(std::size_t n)
+{
+	const Snapshot* snapshot = current.load(std::memory_order_acquire);
+	if (snapshot && (snapshot->size > n || snapshot->size == max_size))
+		return *snapshot;
+	std::lock_guard<std::mutex> lock(mutex);
+	snapshot = current.load(std::memory_order_acquire);
+	const std::size_t old_size = snapshot ? snapshot->size : 0;
+	if (old_size > n || old_size == max_size)
+		return *snapshot;
+	// Grow geometrically so there are only few reallocations.
+	const std::size_t limit = max_size;
+	const std::size_t new_size = std::min(std::max(std::max(n + 1, 2 * old_size), std::size_t(4096)), limit);
+	std::unique_ptr<double[]> table(new double[new_size]);
+	if (snapshot)
+		std::copy(snapshot->data, snapshot->data + old_size, table.get());
+	for (std::size_t i = old_size; i < new_size; ++i)
+	{
+		table[i] = nlogn(double(i));
+	}
+	std::unique_ptr<Snapshot> new_snapshot(new Snapshot{table.get(), new_size});
+	tables.push_back(std::move(table));
+	snapshots.push_back(std::move(new_snapshot));
+	current.store(snapshots.back().get(), std::memory_order_release);
+	return *snapshots.back();
+}
+
+inline double sum_nlogn(const int* counts, const std::size_t size, const NLogNTable::Snapshot& table)
+{
+	double sum = 0;
+	std::size_t i = 0;
+#if defined(__AVX2__)
+	// Four lookups at a time with gathers as long as all counts are in the table.
+	__m256d vsum = _mm256_setzero_pd();
+	const __m128i vtable_size = _mm_set1_epi32(int(table.size));
+	for (; i + 4 <= size; i += 4)
+	{
+		__m128i n = _mm_loadu_si128((const __m128i*)(counts + i));
+		if (_mm_movemask_epi8(_mm_cmplt_epi32(n, vtable_size)) != 0xFFFF)
+			break;
+		vsum = _mm256_add_pd(vsum, _mm256_i32gather_pd(table.data, n, 8));
+	}
+	alignas(32) double partial[4];
+	_mm256_store_pd(partial, vsum);
+	sum = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+#endif
+	for (; i < size; ++i)
+	{
+		const int n = counts[i];
+		sum += std::size_t(n) < table.size ? table.data[n] : NLogNTable::nlogn(double(n));
+	}
+	return sum;
+}
+
+inline double sum_nlogn(const long long* counts, const std::size_t size, const NLogNTable::Snapshot& table)
+{
+	double sum = 0;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		const long long n = counts[i];
+		sum += (unsigned long long)n < table.size ? table.data[n] : NLogNTable::nlogn(double(n));
+	}
+	return sum;
+}
+
+template<typename T, typename Count>
+T mutual_information_from_counts(const Count* H, const Count* hX, const Count* hY,
+	const int binsX, const int binsY, const long long count)
+{
+	if (count <= 0)
+		return T(0);
+	NLogNTable::Snapshot table = NLogNTable::instance().reserve(std::size_t(count));
+	const double joint = sum_nlogn(H, std::size_t(binsX) * binsY, table);
+	const double marginals = sum_nlogn(hX, binsX, table) + sum_nlogn(hY, binsY, table);
+	const double n = double(count);
+	// Clamp tiny negative values caused by rounding (e.g. for independent data).
+	return T(std::max((joint - marginals) / n + std::log2(n), 0.));
+}
+
+template<typename T, typename Count>
+T entropy_from_counts(const Count* counts, const std::size_t size, const long long count)
+{
+	if (count <= 0)
+		return T(0);
+	NLogNTable::Snapshot table = NLogNTable::instance().reserve(std::size_t(count));
+	const double n = double(count);
+	return T(std::max(std::log2(n) - sum_nlogn(counts, size, table) / n, 0.));
+}
+
+template<typename T, typename Count>
+T mutual_information_from_joint_counts(const Count* H, const int binsX, const int binsY, Count* hX, Count* hY)
+{
+	std::fill(hY, hY + binsY, 0);
+	long long count = 0;
+	for (int x = 0; x < binsX; ++x)
+	{
+		const Count* row = H + std::size_t(x) * binsY;
+		hX[x] = 0;
+		for (int y = 0; y < binsY; ++y)
+		{
+			hX[x] += row[y];
+			hY[y] += row[y];
+		}
+		count += hX[x];
+	}
+	return mutual_information_from_counts<T>(H, hX, hY, binsX, binsY, count);
+}
@@ -0,0 +1,227 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include "Histogram2d.h"
+#include "utilities.h"
+
+/**
+ * Shifted mutual information of two growing data series.
+ * Samples of both series are appended in blocks; the joint histogram of every shift
+ * is updated with only those pairs that involve new samples. An append therefore costs
+ * (number of new samples) x (number of shifts), independent of the length of the history.
+ * Only the last max|shift| indices of each series are kept.
+ * After appending the same data, mutual_information() gives exactly the same values as
+ * shifted_mutual_information on the whole data (shifts not fitting the data yet are 0).
+ * @param Index Type for the histogram indices; must be able to hold the number of bins.
+ * @param Count Counter type of the histograms; use long long if more than INT_MAX
+ *        samples will be appended (see Histogram2d).
+ */
+template<typename T, typename Index = int, typename Count = int>
+class ShiftedMutualInformationStream
+{
+public:
+	/**
+	 * Parameters are the same as for shifted_mutual_information.
+	 * Since the data is not known in advance, the ranges of values must be given.
+	 */
+	ShiftedMutualInformationStream(const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const int shift_step=1);
+
+	/**
+	 * Append new samples to both series.
+	 * Both ranges must have the same size.
+	 */
+	template<typename Iterator>
+	void append(const Iterator beginX, const Iterator endX,
+		const Iterator beginY, const Iterator endY);
+
+	/**
+	 * Calculate the mutual information of all shifts for the data appended so far.
+	 * @return Vector of size (shift_to - shift_from) / shift_step + 1.
+	 */
+	std::vector<T> mutual_information() const;
+
+	/**
+	 * Number of samples appended to each series so far.
+	 */
+	std::size_t size() const;
+
+	/**
+	 * Get the histogram of the shift with the given index (0 for shift_from).
+	 */
+	const Histogram2d<T, Count>& getHistogram(const int shift_index) const;
+
+	int getNrShifts() const;
+
+private:
+	const int shift_from;
+	const int shift_to;
+	const int shift_step;
+	const int binsX;
+	const int binsY;
+	const T minX;
+	const T maxX;
+	const T minY;
+	const T maxY;
+	// Number of samples needed to form the pairs of new samples with older ones.
+	std::size_t history;
+	// Total number of samples appended.
+	std::size_t total;
+	// Absolute position of the first index held in X and Y.
+	std::size_t offset;
+	std::vector<Index> X;
+	std::vector<Index> Y;
+	std::vector< std::unique_ptr<Histogram2d<T, Count>> > hists;
+
+	void check_constructor() const;
+};
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename T, typename Index, typename Count>
+ShiftedMutualInformationStream<T, Index, Count>::ShiftedMutualInformationStream(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const int shift_step /* 1 */)
+	: shift_from(shift_from), shift_to(shift_to), shift_step(shift_step),
+	binsX(binsX), binsY(binsY), minX(minX), maxX(maxX), minY(minY), maxY(maxY),
+	total(0), offset(0)
+{
+	check_constructor();
+	history = std::max(std::abs(shift_from), std::abs(shift_to));
+	for (int i = shift_from; i <= shift_to; i += shift_step)
+	{
+		hists.emplace_back(new Histogram2d<T, Count>(binsX, binsY, minX, maxX, minY, maxY));
+	}
+}
+
+template<typename T, typename Index, typename Count>
+void ShiftedMutualInformationStream<T, Index, Count>::check_constructor() const
+{
+	if (shift_from >= shift_to)
+		throw std::logic_error("shift_from has to be smaller than shift_to.");
+	if (shift_step < 1)
+		throw std::invalid_argument("shift_step must be greater or equal 1.");
+	if (minX >= maxX)
+		throw std::logic_error("minX has to be smaller than maxX.");
+	if (minY >= maxY)
+		throw std::logic_error("minY has to be smaller than maxY.");
+	if (binsX < 1)
+		throw std::invalid_argument("There must be at least one binX.");
+	if (binsY < 1)
+		throw std::invalid_argument("There must be at least one binY.");
+	if ((long long)std::max(binsX, binsY) >= (long long)index_sentinel<Index>())
+		throw std::invalid_argument("Index type is too narrow for this number of bins.");
+}
+
+template<typename T, typename Index, typename Count>
+template<typename Iterator>
+void ShiftedMutualInformationStream<T, Index, Count>::append(const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY)
+{
+	const std::size_t added = std::distance(beginX, endX);
+	if ((std::size_t)std::distance(beginY, endY) != added)
+		throw std::logic_error("Both series must be appended with the same number of samples.");
+	if (added == 0)
+		return;
+	std::vector<Index> newX = calculate_indices_1d<Index>(binsX, minX, maxX, beginX, endX);
+	std::vector<Index> newY = calculate_indices_1d<Index>(binsY, minY, maxY, beginY, endY);
+	X.insert(X.end(), newX.begin(), newX.end());
+	Y.insert(Y.end(), newY.begin(), newY.end());
+	const long long n = total;
+	const long long N = total + added;
+	const long long first = offset;
+	const Index* x = X.data();
+	const Index* y = Y.data();
+	const int nr_shifts = getNrShifts();
+#pragma omp parallel for schedule(static)
+	for (int s = 0; s < nr_shifts; ++s)
+	{
+		// Shift i pairs X[k] with Y[k - i] for k in [max(0, i), N + min(0, i)).
+		// Pairs not seen before have X[k] or Y[k - i] among the new samples: k >= n + min(0, i).
+		const long long i = shift_from + (long long)s * shift_step;
+		const long long begin = std::max(std::max(0LL, i), n + std::min(0LL, i));
+		const long long end = N + std::min(0LL, i);
+		if (begin < end)
+		{
+			hists[s]->increment_cpu(x + (begin - first), x + (end - first),
+				y + (begin - i - first), y + (end - i - first));
+		}
+	}
+	total = N;
+	// Drop indices which can not be part of new pairs anymore (if at least as many as are kept).
+	if (total - offset >= 2 * history)
+	{
+		const std::size_t drop = total - offset - history;
+		X.erase(X.begin(), X.begin() + drop);
+		Y.erase(Y.begin(), Y.begin() + drop);
+		offset += drop;
+	}
+}
+
+template<typename T, typename Index, typename Count>
+std::vector<T> ShiftedMutualInformationStream<T, Index, Count>::mutual_information() const
+{
+	const int nr_shifts = getNrShifts();
+	std::vector<T> result(nr_shifts);
+#pragma omp parallel
+	{
+		std::vector<Count> hX(binsX);
+		std::vector<Count> hY(binsY);
+#pragma omp for schedule(static)
+		for (int s = 0; s < nr_shifts; ++s)
+		{
+			result[s] = mutual_information_from_joint_counts<T>(
+				hists[s]->getHistogram().data(), binsX, binsY, hX.data(), hY.data());
+		}
+	}
+	return result;
+}
+
+template<typename T, typename Index, typename Count>
+std::size_t ShiftedMutualInformationStream<T, Index, Count>::size() const
+{
+	return total;
+}
+
+template<typename T, typename Index, typename Count>
+const Histogram2d<T, Count>& ShiftedMutualInformationStream<T, Index, Count>::getHistogram(const int shift_index) const
+{
+	return *hists.at(shift_index);
+}
+
+template<typename T, typename Index, typename Count>
+int ShiftedMutualInformationStream<T, Index, Count>::getNrShifts() const
+{
+	return int(hists.size());
+}
@@ -23,6 +23,7 @@
 #include <vector>
 #include <cctype>
 #include <stdexcept>
+#include <memory>
 #include "ISimpleFile.h"
 
 enum Precision
@@ -56,13 +57,22 @@ public:
 	 */
 	void writeData(const std::vector<T>& data_to_write) override;
 
+	std::size_t readChunk(std::vector<T>& chunk, std::size_t max_values) override;
+
+	void rewind() override;
+
 private:
 	const std::string path;
     Precision precision;
 	std::vector<T> data;
+	// Stream for reading chunks; opened on first use.
+	std::unique_ptr<std::ifstream> reader;
 
     template<typename Prec>
 	void parse_file(const std::string& input);
+
+	template<typename Prec>
+	std::size_t read_chunk(std::vector<T>& chunk, std::size_t max_values);
 };
 
 
@@ -129,4 +139,40 @@ void SimpleBinaryFile<T>::parse_file(const std::string& path) {
 		throw std::runtime_error(what_arg);
 	}
 	fs.close();
-}
\ No newline at end of file
+}
+
+template<typename T>
+std::size_t SimpleBinaryFile<T>::readChunk(std::vector<T>& chunk, std::size_t max_values)
+{
+	if (!reader)
+		rewind();
+	if (precision == PREC_32)
+		return read_chunk<float>(chunk, max_values);
+	else if (precision == PREC_64)
+		return read_chunk<double>(chunk, max_values);
+	else
+		throw std::invalid_argument("Precision must PREC_32 or PREC_64.");
+}
+
+template<typename T>
+void SimpleBinaryFile<T>::rewind()
+{
+	reader.reset(new std::ifstream(path, std::ifstream::binary));
+	if (!reader->is_open())
+	{
+		std::string what_arg("Could not open file: ");
+		what_arg.append(path);
+		throw std::runtime_error(what_arg);
+	}
+}
+
+template<typename T>
+template<typename Prec>
+std::size_t SimpleBinaryFile<T>::read_chunk(std::vector<T>& chunk, std::size_t max_values)
+{
+	std::vector<Prec> buffer(max_values);
+	reader->read((char*)buffer.data(), max_values * sizeof(Prec));
+	const std::size_t nr_values = reader->gcount() / sizeof(Prec);
+	chunk.assign(buffer.begin(), buffer.begin() + nr_values);
+	return nr_values;
+}
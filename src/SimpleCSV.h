@@ -23,6 +23,7 @@
 #include <vector>
 #include <cctype>
 #include <stdexcept>
+#include <memory>
 
 #include "ISimpleFile.h"
 
@@ -54,10 +55,16 @@ public:
 	 */
 	void writeData(const std::vector<T>& data_to_write) override;
 
+	std::size_t readChunk(std::vector<T>& chunk, std::size_t max_values) override;
+
+	void rewind() override;
+
 private:
 	const std::string path;
     const char delimiter;
 	std::vector<T> data;
+	// Stream for reading chunks; opened on first use.
+	std::unique_ptr<std::ifstream> reader;
 
 	void parse_file(const std::string& input);
 
@@ -137,18 +144,57 @@ void SimpleCSV<T>::parse_file(const std::string& path) {
 	fs.close();
 }
 
+template<typename T>
+std::size_t SimpleCSV<T>::readChunk(std::vector<T>& chunk, std::size_t max_values)
+{
+	if (!reader)
+		rewind();
+	chunk.clear();
+	std::string number;
+	// Same parsing as in parse_file; a chunk always ends after a complete number.
+	while (chunk.size() < max_values && reader->good())
+	{
+		char c = reader->get();
+		if (c == this->delimiter || c == '\n')
+		{
+			if (!number.empty())
+			{
+				chunk.push_back(stox(number));
+				number.clear();
+			}
+		}
+		else if (!isspace(c))
+		{
+			number.push_back(c);
+		}
+	}
+	return chunk.size();
+}
+
+template<typename T>
+void SimpleCSV<T>::rewind()
+{
+	reader.reset(new std::ifstream(this->path));
+	if (!reader->is_open())
+	{
+		std::string what_arg("Could not open file: ");
+		what_arg.append(this->path);
+		throw std::runtime_error(what_arg);
+	}
+}
+
 // Template specialization for conversion to float or double.
 template<typename T>
 T SimpleCSV<T>::stox(const std::string& str) {}
 
 template<>
-float SimpleCSV<float>::stox(const std::string& str)
+inline float SimpleCSV<float>::stox(const std::string& str)
 {
 	return std::stof(str);
 }
 
 template<>
-double SimpleCSV<double>::stox(const std::string& str)
+inline double SimpleCSV<double>::stox(const std::string& str)
 {
 	return std::stod(str);
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "Histogram2d.h"
+#include "utilities.h"
+
+/**
+ * Bytes of index arrays of one block of channels in the all-pairs engine.
+ * Two blocks of channels should stay in the (L2) cache while all their pairs are processed.
+ */
+constexpr std::size_t all_pairs_block_bytes {std::size_t(1) << 19};
+
+/**
+ * Calculate the shifted mutual information for every ordered pair of channels.
+ * Each channel is binned once. The pairs are processed in blocks of channels
+ * (see all_pairs_block_bytes) and MI(i,j,s) = MI(j,i,-s) is used to skip about half of the shifts.
+ * @param shift_from Start shifting from here.
+ * @param shift_to Stop shifting here (inclusive).
+ * @param bins Number of bins for all channels.
+ * @param channels Data of all channels; they must have the same size.
+ * @param mins Minimum value for each channel; if empty the minimum of each channel is used.
+ * @param maxs Maximum value for each channel; if empty the maximum of each channel is used.
+ * @param shift_step Step size between shifts. (default: 1)
+ * @return Tensor with N x N x nr_shifts values where N is the number of channels; the value at
+ *         (i * N + j) * nr_shifts + k is the mutual information of channel i and channel j
+ *         shifted by shift_from + k * shift_step (as in shifted_mutual_information).
+ */
+template<typename T>
+std::vector<T> all_pairs_shifted_mutual_information(
+	const int shift_from, const int shift_to, const int bins,
+	const std::vector< std::vector<T> >& channels,
+	const std::vector<T>& mins = std::vector<T>(),
+	const std::vector<T>& maxs = std::vector<T>(),
+	const int shift_step = 1);
+
+/**
+ * Helper for all_pairs_shifted_mutual_information after the channels are binned.
+ * @param indices Index arrays of all channels.
+ * @param output Has to hold N x N x nr_shifts values.
+ * @tparam Count Counter type of the histograms (see needs_wide_counts).
+ */
+template<typename T, typename Index, typename Count = int>
+void all_pairs_shifted_mutual_information_from_indices(
+	const int shift_from, const int shift_to, const int bins,
+	const std::vector< std::vector<Index> >& indices,
+	const std::vector<T>& mins, const std::vector<T>& maxs,
+	const int shift_step, T* output);
+
+/**
+ * Helper for all_pairs_shifted_mutual_information with a specific index type.
+ */
+template<typename Index, typename T>
+std::vector<T> all_pairs_shifted_mutual_information_binned(
+	const int shift_from, const int shift_to, const int bins,
+	const std::vector< std::vector<T> >& channels,
+	const std::vector<T>& mins, const std::vector<T>& maxs,
+	const int shift_step);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename T>
+std::vector<T> all_pairs_shifted_mutual_information(
+	const int shift_from, const int shift_to, const int bins,
+	const std::vector< std::vector<T> >& channels,
+	const std::vector<T>& mins /* empty */,
+	const std::vector<T>& maxs /* empty */,
+	const int shift_step /* 1 */)
+{
+	const std::size_t nr_channels = channels.size();
+	if (nr_channels == 0)
+		throw std::invalid_argument("There must be at least one channel.");
+	if (!mins.empty() && mins.size() != nr_channels)
+		throw std::invalid_argument("There must be one minimum for each channel.");
+	if (!maxs.empty() && maxs.size() != nr_channels)
+		throw std::invalid_argument("There must be one maximum for each channel.");
+	std::vector<T> channel_mins(nr_channels);
+	std::vector<T> channel_maxs(nr_channels);
+	for (std::size_t c = 0; c < nr_channels; ++c)
+	{
+		if (channels[c].empty())
+			throw std::invalid_argument("Channels must not be empty.");
+		auto minmax = std::minmax_element(channels[c].begin(), channels[c].end());
+		channel_mins[c] = mins.empty() ? *minmax.first : mins[c];
+		channel_maxs[c] = maxs.empty() ? *minmax.second : maxs[c];
+		check_shifted_mutual_information(channels[0].size(), channels[c].size(), shift_from, shift_to,
+			bins, bins, channel_mins[c], channel_maxs[c], channel_mins[c], channel_maxs[c], shift_step);
+	}
+	switch (index_width(bins))
+	{
+	case 1:
+		return all_pairs_shifted_mutual_information_binned<uint8_t>(
+			shift_from, shift_to, bins, channels, channel_mins, channel_maxs, shift_step);
+	case 2:
+		return all_pairs_shifted_mutual_information_binned<uint16_t>(
+			shift_from, shift_to, bins, channels, channel_mins, channel_maxs, shift_step);
+	default:
+		return all_pairs_shifted_mutual_information_binned<int>(
+			shift_from, shift_to, bins, channels, channel_mins, channel_maxs, shift_step);
+	}
+}
+
+template<typename Index, typename T>
+std::vector<T> all_pairs_shifted_mutual_information_binned(
+	const int shift_from, const int shift_to, const int bins,
+	const std::vector< std::vector<T> >& channels,
+	const std::vector<T>& mins, const std::vector<T>& maxs,
+	const int shift_step)
+{
+	const std::size_t nr_channels = channels.size();
+	std::vector< std::vector<Index> > indices(nr_channels);
+	for (std::size_t c = 0; c < nr_channels; ++c)
+	{
+		indices[c] = calculate_indices_1d<Index>(bins, mins[c], maxs[c], channels[c].begin(), channels[c].end());
+	}
+	const std::size_t nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	std::vector<T> result(nr_channels * nr_channels * nr_shifts);
+	if (needs_wide_counts(channels[0].size()))
+		all_pairs_shifted_mutual_information_from_indices<T, Index, long long>(
+			shift_from, shift_to, bins, indices, mins, maxs, shift_step, result.data());
+	else
+		all_pairs_shifted_mutual_information_from_indices<T, Index, int>(
+			shift_from, shift_to, bins, indices, mins, maxs, shift_step, result.data());
+	return result;
+}
+
+template<typename T, typename Index, typename Count>
+void all_pairs_shifted_mutual_information_from_indices(
+	const int shift_from, const int shift_to, const int bins,
+	const std::vector< std::vector<Index> >& indices,
+	const std::vector<T>& mins, const std::vector<T>& maxs,
+	const int shift_step, T* output)
+{
+	const int nr_channels = int(indices.size());
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const std::size_t size = indices[0].size();
+	// Index of the negated shift or -1 if it is not one of the shifts.
+	std::vector<int> mirror(nr_shifts, -1);
+	for (int k = 0; k < nr_shifts; ++k)
+	{
+		const int negated = -(shift_from + k * shift_step) - shift_from;
+		if (negated >= 0 && negated % shift_step == 0 && negated / shift_step < nr_shifts)
+			mirror[k] = negated / shift_step;
+	}
+	const int block = int(std::max(std::size_t(1), all_pairs_block_bytes / (size * sizeof(Index))));
+	const int nr_blocks = (nr_channels + block - 1) / block;
+	std::vector< std::pair<int, int> > block_pairs;
+	for (int bi = 0; bi < nr_blocks; ++bi)
+	{
+		for (int bj = bi; bj < nr_blocks; ++bj)
+		{
+			block_pairs.push_back(std::make_pair(bi, bj));
+		}
+	}
+	// Split the shifts too if there are not enough blocks for all threads.
+	const int nr_block_pairs = int(block_pairs.size());
+	const int wanted = 4 * shift_engine_threads();
+	const int shift_chunks = std::min(nr_shifts, std::max(1, (wanted + nr_block_pairs - 1) / nr_block_pairs));
+	const int chunk_shifts = (nr_shifts + shift_chunks - 1) / shift_chunks;
+	const int nr_tasks = nr_block_pairs * shift_chunks;
+	auto at = [nr_channels, nr_shifts](const int i, const int j, const int k) {
+		return (std::size_t(i) * nr_channels + j) * nr_shifts + k;
+	};
+#pragma omp parallel for schedule(dynamic)
+	for (int task = 0; task < nr_tasks; ++task)
+	{
+		const int bi = block_pairs[task / shift_chunks].first;
+		const int bj = block_pairs[task / shift_chunks].second;
+		const int k_from = (task % shift_chunks) * chunk_shifts;
+		const int k_to = std::min(k_from + chunk_shifts, nr_shifts);
+		for (int i = bi * block, i_end = std::min(i + block, nr_channels); i < i_end; ++i)
+		{
+			for (int j = bi == bj ? i : bj * block, j_end = std::min(bj * block + block, nr_channels); j < j_end; ++j)
+			{
+				const Index* X = indices[i].data();
+				const Index* Y = indices[j].data();
+				Histogram2d<T, Count> hist(bins, bins, mins[i], maxs[i], mins[j], maxs[j]);
+				Histogram2d<T, Count> transposed(bins, bins, mins[j], maxs[j], mins[i], maxs[i]);
+				for (int k = k_from; k < k_to; ++k)
+				{
+					const int shift = shift_from + k * shift_step;
+					// On the diagonal the negative shifts give the positive ones.
+					if (i < j || shift <= 0 || mirror[k] < 0)
+					{
+						hist.reset();
+						increment_shifted(hist, shift, X, X + size, Y, Y + size);
+						output[at(i, j, k)] = *hist.calculate_mutual_information();
+					}
+					if (i < j && mirror[k] < 0)
+					{
+						transposed.reset();
+						increment_shifted(transposed, shift, Y, Y + size, X, X + size);
+						output[at(j, i, k)] = *transposed.calculate_mutual_information();
+					}
+				}
+			}
+		}
+	}
+	for (int i = 0; i < nr_channels; ++i)
+	{
+		for (int j = 0; j <= i; ++j)
+		{
+			for (int k = 0; k < nr_shifts; ++k)
+			{
+				const int shift = shift_from + k * shift_step;
+				if (mirror[k] >= 0 && (j < i || shift > 0))
+					output[at(i, j, k)] = output[at(j, i, mirror[k])];
+			}
+		}
+	}
+}
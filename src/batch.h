@@ -0,0 +1,308 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <map>
+#include <tuple>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <istream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "Histogram2d.h"
+#include "utilities.h"
+
+/**
+ * One pair of data files of a batch with the options for its calculation.
+ * NaN as minimum or maximum means: use the smallest or largest value of the file.
+ */
+template<typename T>
+struct BatchPair
+{
+	std::string path1;
+	std::string path2;
+	int shift_from;
+	int shift_to;
+	int shift_step;
+	int binsX;
+	int binsY;
+	T min1;
+	T max1;
+	T min2;
+	T max2;
+	// Where to write the results; empty if not given.
+	std::string outfile;
+	// Line in the manifest for error messages.
+	int line;
+};
+
+/**
+ * Parse a batch manifest. Each line holds the paths of two data files, optionally followed by
+ * options as key=value which override the defaults for this pair:
+ * shift_from, shift_to, shift_step, bins_x, bins_y, min1, max1, min2, max2, outfile.
+ * Empty lines and lines starting with # are ignored.
+ * @param defaults Options for all pairs (paths and line are ignored).
+ * @throws std::invalid_argument for malformed lines.
+ */
+template<typename T>
+std::vector< BatchPair<T> > parse_batch_manifest(std::istream& manifest, const BatchPair<T>& defaults);
+
+/**
+ * Read and parse a batch manifest file, see parse_batch_manifest.
+ */
+template<typename T>
+std::vector< BatchPair<T> > read_batch_manifest(const std::string& path, const BatchPair<T>& defaults);
+
+/**
+ * Calculate shifted mutual information for all pairs of a batch at once.
+ * Every distinct file is loaded only once and binned once for each distinct
+ * number of bins and range of values. Then all shifts of all pairs are scheduled
+ * on one team of threads; each task is a block of consecutive shifts of one pair.
+ * @param pairs Ranges given as NaN are replaced with the actual ranges of the files.
+ * @param load Function or functor taking a path and returning a std::vector<T> with its data.
+ * @return For each pair a vector with the mutual information of all its shifts.
+ * @throws std::logic_error if the options of a pair are invalid (with the line in the manifest).
+ */
+template<typename T, typename Loader>
+std::vector< std::vector<T> > batch_shifted_mutual_information(std::vector< BatchPair<T> >& pairs, Loader load);
+
+/**
+ * Helper for dispatching batch_shifted_mutual_information to the narrowest index type
+ * which fits the bins of all pairs.
+ */
+template<typename Index, typename T, typename Loader>
+std::vector< std::vector<T> > batch_shifted_mutual_information_binned(std::vector< BatchPair<T> >& pairs, Loader load);
+
+/**
+ * Calculate the shifts [first, last) of a pair with one histogram counting in Count.
+ */
+template<typename Count, typename T, typename Index>
+void batch_shift_block(const BatchPair<T>& pair, const std::vector<Index>& x, const std::vector<Index>& y,
+	const int first, const int last, T* output);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename T>
+std::vector< BatchPair<T> > parse_batch_manifest(std::istream& manifest, const BatchPair<T>& defaults)
+{
+	std::vector< BatchPair<T> > pairs;
+	std::string text;
+	for (int line = 1; std::getline(manifest, text); ++line)
+	{
+		std::istringstream tokens(text);
+		BatchPair<T> pair(defaults);
+		pair.line = line;
+		if (!(tokens >> pair.path1) || pair.path1[0] == '#')
+			continue;
+		const std::string where = "manifest line " + std::to_string(line) + ": ";
+		if (!(tokens >> pair.path2))
+			throw std::invalid_argument(where + "two paths are needed.");
+		std::string option;
+		while (tokens >> option)
+		{
+			const std::size_t separator = option.find('=');
+			if (separator == std::string::npos)
+				throw std::invalid_argument(where + "options must look like key=value: " + option);
+			const std::string key = option.substr(0, separator);
+			const std::string value = option.substr(separator + 1);
+			try
+			{
+				if (key == "shift_from")
+					pair.shift_from = std::stoi(value);
+				else if (key == "shift_to")
+					pair.shift_to = std::stoi(value);
+				else if (key == "shift_step")
+					pair.shift_step = std::stoi(value);
+				else if (key == "bins_x")
+					pair.binsX = std::stoi(value);
+				else if (key == "bins_y")
+					pair.binsY = std::stoi(value);
+				else if (key == "min1")
+					pair.min1 = T(std::stod(value));
+				else if (key == "max1")
+					pair.max1 = T(std::stod(value));
+				else if (key == "min2")
+					pair.min2 = T(std::stod(value));
+				else if (key == "max2")
+					pair.max2 = T(std::stod(value));
+				else if (key == "outfile")
+					pair.outfile = value;
+				else
+					throw std::invalid_argument(where + "unknown option " + key);
+			}
+			catch (const std::logic_error& e)
+			{
+				if (std::string(e.what()).compare(0, where.size(), where) == 0)
+					throw;
+				throw std::invalid_argument(where + "invalid value for " + key + ": " + value);
+			}
+		}
+		pairs.push_back(pair);
+	}
+	return pairs;
+}
+
+template<typename T>
+std::vector< BatchPair<T> > read_batch_manifest(const std::string& path, const BatchPair<T>& defaults)
+{
+	std::ifstream fs(path);
+	if (!fs.is_open())
+	{
+		std::string what_arg("Could not open file: ");
+		what_arg.append(path);
+		throw std::runtime_error(what_arg);
+	}
+	return parse_batch_manifest(fs, defaults);
+}
+
+template<typename T, typename Loader>
+std::vector< std::vector<T> > batch_shifted_mutual_information(std::vector< BatchPair<T> >& pairs, Loader load)
+{
+	int bins = 1;
+	for (const BatchPair<T>& pair : pairs)
+	{
+		bins = std::max(bins, std::max(pair.binsX, pair.binsY));
+	}
+	switch (index_width(bins))
+	{
+	case 1:
+		return batch_shifted_mutual_information_binned<uint8_t>(pairs, load);
+	case 2:
+		return batch_shifted_mutual_information_binned<uint16_t>(pairs, load);
+	default:
+		return batch_shifted_mutual_information_binned<int>(pairs, load);
+	}
+}
+
+template<typename Index, typename T, typename Loader>
+std::vector< std::vector<T> > batch_shifted_mutual_information_binned(std::vector< BatchPair<T> >& pairs, Loader load)
+{
+	// Indices of each distinct combination of file, number of bins and range.
+	typedef std::tuple<std::string, int, T, T> BinningKey;
+	std::map< BinningKey, std::vector<Index> > indices;
+	std::vector<std::string> paths;
+	for (const BatchPair<T>& pair : pairs)
+	{
+		paths.push_back(pair.path1);
+		paths.push_back(pair.path2);
+	}
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+	// Load one file at a time and keep only its indices.
+	for (const std::string& path : paths)
+	{
+		const std::vector<T> data = load(path);
+		if (data.empty())
+			throw std::logic_error("No data in file: " + path);
+		const auto minmax = std::minmax_element(data.begin(), data.end());
+		for (BatchPair<T>& pair : pairs)
+		{
+			if (pair.path1 == path)
+			{
+				pair.min1 = std::isnan(pair.min1) ? *minmax.first : pair.min1;
+				pair.max1 = std::isnan(pair.max1) ? *minmax.second : pair.max1;
+				BinningKey key(path, pair.binsX, pair.min1, pair.max1);
+				if (pair.min1 < pair.max1 && pair.binsX > 0 && !indices.count(key))
+					indices[key] = calculate_indices_1d<Index>(pair.binsX, pair.min1, pair.max1, data.begin(), data.end());
+			}
+			if (pair.path2 == path)
+			{
+				pair.min2 = std::isnan(pair.min2) ? *minmax.first : pair.min2;
+				pair.max2 = std::isnan(pair.max2) ? *minmax.second : pair.max2;
+				BinningKey key(path, pair.binsY, pair.min2, pair.max2);
+				if (pair.min2 < pair.max2 && pair.binsY > 0 && !indices.count(key))
+					indices[key] = calculate_indices_1d<Index>(pair.binsY, pair.min2, pair.max2, data.begin(), data.end());
+			}
+		}
+	}
+	// Check all pairs before starting any calculation.
+	std::vector<const std::vector<Index>*> X(pairs.size());
+	std::vector<const std::vector<Index>*> Y(pairs.size());
+	std::vector< std::vector<T> > results(pairs.size());
+	long long total_shifts = 0;
+	for (std::size_t p = 0; p < pairs.size(); ++p)
+	{
+		const BatchPair<T>& pair = pairs[p];
+		try
+		{
+			// Options first: the indices only exist for valid bins and ranges.
+			check_shifted_mutual_information(SIZE_MAX, SIZE_MAX, pair.shift_from, pair.shift_to,
+				pair.binsX, pair.binsY, pair.min1, pair.max1, pair.min2, pair.max2, pair.shift_step);
+			X[p] = &indices.at(BinningKey(pair.path1, pair.binsX, pair.min1, pair.max1));
+			Y[p] = &indices.at(BinningKey(pair.path2, pair.binsY, pair.min2, pair.max2));
+			check_shifted_mutual_information(X[p]->size(), Y[p]->size(), pair.shift_from, pair.shift_to,
+				pair.binsX, pair.binsY, pair.min1, pair.max1, pair.min2, pair.max2, pair.shift_step);
+		}
+		catch (const std::logic_error& e)
+		{
+			throw std::logic_error("manifest line " + std::to_string(pair.line) + ": " + e.what());
+		}
+		results[p].resize((pair.shift_to - pair.shift_from) / pair.shift_step + 1);
+		total_shifts += results[p].size();
+	}
+	// Blocks of shifts small enough to balance the load but large enough to reuse a histogram.
+	const long long block = std::max(1LL, std::min(64LL, total_shifts / (8LL * shift_engine_threads())));
+	std::vector< std::pair<std::size_t, int> > tasks;
+	for (std::size_t p = 0; p < pairs.size(); ++p)
+	{
+		for (std::size_t s = 0; s < results[p].size(); s += block)
+		{
+			tasks.push_back(std::make_pair(p, int(s)));
+		}
+	}
+	const int nr_tasks = int(tasks.size());
+#pragma omp parallel for schedule(dynamic)
+	for (int t = 0; t < nr_tasks; ++t)
+	{
+		const std::size_t p = tasks[t].first;
+		const BatchPair<T>& pair = pairs[p];
+		const std::vector<Index>& x = *X[p];
+		const std::vector<Index>& y = *Y[p];
+		const int first = tasks[t].second;
+		const int last = std::min(first + int(block), int(results[p].size()));
+		if (needs_wide_counts(x.size()))
+			batch_shift_block<long long>(pair, x, y, first, last, results[p].data());
+		else
+			batch_shift_block<int>(pair, x, y, first, last, results[p].data());
+	}
+	return results;
+}
+
+template<typename Count, typename T, typename Index>
+void batch_shift_block(const BatchPair<T>& pair, const std::vector<Index>& x, const std::vector<Index>& y,
+	const int first, const int last, T* output)
+{
+	Histogram2d<T, Count> hist(pair.binsX, pair.binsY, pair.min1, pair.max1, pair.min2, pair.max2);
+	for (int s = first; s < last; ++s)
+	{
+		hist.reset();
+		increment_shifted(hist, pair.shift_from + s * pair.shift_step,
+			x.data(), x.data() + x.size(), y.data(), y.data() + y.size());
+		output[s] = *hist.calculate_mutual_information();
+	}
+}
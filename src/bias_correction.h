@@ -0,0 +1,168 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+
+/**
+ * Analytical corrections of the bias of the plug-in estimate of mutual information.
+ * They only need the numbers of occupied bins and cost next to nothing
+ * compared to filling the histograms, unlike bootstrapping.
+ */
+enum BiasCorrection
+{
+	BIAS_NONE,           // Plug-in estimate from the frequencies.
+	BIAS_MILLER_MADOW,   // Occupied bins of the joint and marginal histograms.
+	BIAS_PANZERI_TREVES  // Relevant bins of every row and of the marginal of Y (Panzeri & Treves, 1996).
+};
+
+/**
+ * Names of all corrections in the order of BiasCorrection (e.g. for the command line).
+ */
+inline const std::vector<std::string>& bias_correction_names();
+
+/**
+ * Get the correction for one of the names in bias_correction_names.
+ */
+inline BiasCorrection bias_correction_from_name(const std::string& name);
+
+/**
+ * Estimate how many bins of a histogram have a non-zero probability.
+ * These are the occupied bins plus those which are likely to be empty by chance:
+ * the unseen probability mass is taken from the singletons (Good-Turing) and split
+ * evenly over the empty bins, and the estimate is the number of bins whose expected
+ * number of occupied bins for total samples comes closest to the observed one.
+ * @param counts Histogram of size bins.
+ * @param total Sum of all counts.
+ */
+template<typename Count>
+int relevant_bins(const Count* counts, const int bins, const long long total);
+
+/**
+ * Estimate the bias (in bits) of the plug-in mutual information of a histogram.
+ * The corrected estimate is the plug-in one minus this bias.
+ * For Miller-Madow it is (m_xy - m_x - m_y + 1) / (2 N ln 2) with the numbers m of occupied bins.
+ * For Panzeri-Treves it is (sum_x (R_x - 1) - (R_y - 1)) / (2 N ln 2) where R_x are the
+ * relevant bins (see relevant_bins) of row x of the joint histogram and R_y those of the marginal of Y.
+ * @param H Row-major joint histogram of size binsX * binsY.
+ * @param hX Marginal histogram of size binsX.
+ * @param hY Marginal histogram of size binsY.
+ * @param count Total number of values in H.
+ */
+template<typename Count>
+double mutual_information_bias(const Count* H, const Count* hX, const Count* hY,
+		const int binsX, const int binsY, const long long count, const BiasCorrection correction);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline const std::vector<std::string>& bias_correction_names()
+{
+	static const std::vector<std::string> names {"none", "miller_madow", "panzeri_treves"};
+	return names;
+}
+
+inline BiasCorrection bias_correction_from_name(const std::string& name)
+{
+	const std::vector<std::string>& names = bias_correction_names();
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		if (names[i] == name)
+			return static_cast<BiasCorrection>(i);
+	}
+	throw std::invalid_argument("Unknown bias correction: " + name);
+}
+
+template<typename Count>
+int relevant_bins(const Count* counts, const int bins, const long long total)
+{
+	int occupied = 0;
+	int singletons = 0;
+	for (int i = 0; i < bins; ++i)
+	{
+		occupied += counts[i] > 0;
+		singletons += counts[i] == 1;
+	}
+	if (occupied == bins || singletons == 0)
+		return occupied;
+	const double n = double(total);
+	const double unseen = singletons / n;
+	// Expected number of occupied bins among the occupied ones.
+	double expected = 0;
+	for (int i = 0; i < bins; ++i)
+	{
+		if (counts[i] > 0)
+			expected += 1. - std::pow(1. - (1. - unseen) * counts[i] / n, n);
+	}
+	// The empty bins add more to the expectation the more of them there are.
+	int best = occupied;
+	double best_distance = occupied - expected;
+	for (int empty = 1; empty <= bins - occupied; ++empty)
+	{
+		const double distance = std::abs(occupied - expected - empty * (1. - std::pow(1. - unseen / empty, n)));
+		if (distance >= best_distance)
+			break;
+		best = occupied + empty;
+		best_distance = distance;
+	}
+	return best;
+}
+
+template<typename Count>
+double mutual_information_bias(const Count* H, const Count* hX, const Count* hY,
+	const int binsX, const int binsY, const long long count, const BiasCorrection correction)
+{
+	if (correction == BIAS_NONE || count <= 0)
+		return 0.;
+	long long degrees = 0;
+	if (correction == BIAS_MILLER_MADOW)
+	{
+		long long occupied = 0;
+		for (std::size_t i = 0, size = std::size_t(binsX) * binsY; i < size; ++i)
+		{
+			occupied += H[i] > 0;
+		}
+		int occupiedX = 0;
+		for (int x = 0; x < binsX; ++x)
+		{
+			occupiedX += hX[x] > 0;
+		}
+		int occupiedY = 0;
+		for (int y = 0; y < binsY; ++y)
+		{
+			occupiedY += hY[y] > 0;
+		}
+		degrees = occupied - occupiedX - occupiedY + 1;
+	}
+	else
+	{
+		for (int x = 0; x < binsX; ++x)
+		{
+			if (hX[x] > 0)
+				degrees += relevant_bins(H + std::size_t(x) * binsY, binsY, hX[x]) - 1;
+		}
+		degrees -= relevant_bins(hY, binsY, count) - 1;
+	}
+	return double(degrees) / (2. * double(count) * std::log(2.));
+}
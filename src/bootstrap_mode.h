@@ -0,0 +1,189 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <random>
+#include <cstddef>
+#include <cmath>
+
+/**
+ * How the replicates of the bootstrap are drawn.
+ */
+enum BootstrapMode
+{
+	BOOTSTRAP_HISTOGRAMS,  // Add up nr_samples histograms drawn from sampled histograms of the data pairs.
+	BOOTSTRAP_MULTINOMIAL  // Draw the joint histogram of every replicate from the multinomial of the observed one.
+};
+
+/**
+ * Names of all modes in the order of BootstrapMode (e.g. for the command line).
+ */
+inline const std::vector<std::string>& bootstrap_mode_names();
+
+/**
+ * Get the mode for one of the names in bootstrap_mode_names.
+ */
+inline BootstrapMode bootstrap_mode_from_name(const std::string& name);
+
+/**
+ * Draw from the binomial distribution of n trials with probability p using only
+ * a few uniform numbers of rgen and no set-up, unlike std::binomial_distribution.
+ * For a mean n * min(p, 1 - p) below 10 the waiting times between successes are
+ * added up, otherwise the transformed rejection of Hormann (1993, BTRS) is used.
+ */
+template<typename Rng>
+long long draw_binomial(Rng& rgen, const long long n, const double p);
+
+/**
+ * Resample a histogram: draw total values from the multinomial distribution with
+ * the probabilities counts / total by sequential binomial splitting. Every cell takes
+ * a binomial share of the values not yet distributed, with the probability of the
+ * cell among the cells not yet visited. This costs one binomial draw per occupied
+ * cell instead of one draw per value; empty cells stay empty.
+ * @param counts Observed histogram of size cells summing up to total.
+ * @param output Receives the resampled histogram; may not be counts.
+ */
+template<typename Rng, typename Count>
+void draw_multinomial(Rng& rgen, const Count* counts, const std::size_t cells,
+		const long long total, Count* output);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline const std::vector<std::string>& bootstrap_mode_names()
+{
+	static const std::vector<std::string> names {"histograms", "multinomial"};
+	return names;
+}
+
+inline BootstrapMode bootstrap_mode_from_name(const std::string& name)
+{
+	const std::vector<std::string>& names = bootstrap_mode_names();
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		if (names[i] == name)
+			return static_cast<BootstrapMode>(i);
+	}
+	throw std::invalid_argument("Unknown bootstrap mode: " + name);
+}
+
+/**
+ * The error of Stirling's approximation of log(k!).
+ */
+inline double stirling_tail(const long long k)
+{
+	static const double small[10] = {
+		0.08106146679532726, 0.04134069595540929, 0.02767792568499834,
+		0.02079067210376509, 0.01664469118982119, 0.01387612882307075,
+		0.01189670994589177, 0.01041126526197209, 0.009255462182712733,
+		0.008330563433362871};
+	if (k < 10)
+		return small[k];
+	const double k1 = double(k + 1);
+	return (1.0 / 12 - (1.0 / 360 - 1.0 / 1260 / (k1 * k1)) / (k1 * k1)) / k1;
+}
+
+template<typename Rng>
+long long draw_binomial(Rng& rgen, const long long n, const double p)
+{
+	if (p <= 0 || n <= 0)
+		return 0;
+	if (p >= 1)
+		return n;
+	if (p > 0.5)
+		return n - draw_binomial(rgen, n, 1 - p);
+	if (n * p < 10)
+	{
+		// Count the successes by adding up geometric waiting times.
+		const double log_q = std::log1p(-p);
+		long long successes = 0;
+		long long position = 0;
+		while (true)
+		{
+			// u has to be in (0, 1): log(1) would be a waiting time of zero.
+			double u;
+			do
+			{
+				u = 1 - std::generate_canonical<double, 53>(rgen);
+			} while (u <= 0 || u >= 1);
+			position += (long long)std::ceil(std::log(u) / log_q);
+			if (position > n)
+				return successes;
+			++successes;
+		}
+	}
+	const double spq = std::sqrt(n * p * (1 - p));
+	const double b = 1.15 + 2.53 * spq;
+	const double a = -0.0873 + 0.0248 * b + 0.01 * p;
+	const double c = n * p + 0.5;
+	const double v_r = 0.92 - 4.2 / b;
+	const double r = p / (1 - p);
+	const double alpha = (2.83 + 5.1 / b) * spq;
+	const long long m = (long long)std::floor((n + 1) * p);
+	while (true)
+	{
+		const double u = std::generate_canonical<double, 53>(rgen) - 0.5;
+		double v = std::generate_canonical<double, 53>(rgen);
+		const double us = 0.5 - std::fabs(u);
+		const long long k = (long long)std::floor((2 * a / us + b) * u + c);
+		if (k < 0 || k > n)
+			continue;
+		if (us >= 0.07 && v <= v_r)
+			return k;
+		v = std::log(v * alpha / (a / (us * us) + b));
+		const double bound = (m + 0.5) * std::log((m + 1) / (r * (n - m + 1)))
+			+ (n + 1) * std::log(double(n - m + 1) / double(n - k + 1))
+			+ (k + 0.5) * std::log(r * (n - k + 1) / (k + 1))
+			+ stirling_tail(m) + stirling_tail(n - m) - stirling_tail(k) - stirling_tail(n - k);
+		if (v <= bound)
+			return k;
+	}
+}
+
+template<typename Rng, typename Count>
+void draw_multinomial(Rng& rgen, const Count* counts, const std::size_t cells,
+		const long long total, Count* output)
+{
+	long long remaining = total;
+	long long mass = total;
+	for (std::size_t c = 0; c < cells; ++c)
+	{
+		if (counts[c] == 0 || remaining == 0)
+		{
+			output[c] = 0;
+		}
+		else if (counts[c] >= mass)
+		{
+			// The last occupied cell takes the rest.
+			output[c] = Count(remaining);
+			remaining = 0;
+		}
+		else
+		{
+			const long long drawn = draw_binomial(rgen, remaining, double(counts[c]) / double(mass));
+			output[c] = Count(drawn);
+			remaining -= drawn;
+			mass -= counts[c];
+		}
+	}
+}
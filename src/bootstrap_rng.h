@@ -0,0 +1,411 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+/**
+ * Random number generators for drawing the bootstrap samples.
+ */
+enum BootstrapRng
+{
+	RNG_MT19937,      // std::mt19937 with std::uniform_int_distribution, one draw at a time.
+	RNG_XOSHIRO256PP, // Four interleaved xoshiro256++ streams with Lemire's bounded integers.
+	RNG_PHILOX        // Philox4x32-10 with a separate stream for every sample and repetition.
+};
+
+/**
+ * Streams of the random numbers of one shift (see bootstrap_stream).
+ */
+enum BootstrapStream
+{
+	STREAM_SAMPLE,     // Data pairs of a sampled histogram.
+	STREAM_REPETITION  // Histograms added up in a repetition.
+};
+
+/**
+ * Names of all generators in the order of BootstrapRng (e.g. for the command line).
+ */
+inline const std::vector<std::string>& bootstrap_rng_names();
+
+/**
+ * Get the generator for one of the names in bootstrap_rng_names.
+ */
+inline BootstrapRng bootstrap_rng_from_name(const std::string& name);
+
+/**
+ * A seed taken from the clock for runs without a given seed.
+ */
+inline uint64_t clock_seed();
+
+/**
+ * The seed for the generator of a single shift. It only depends on seed and the
+ * value of the shift, so any shift range and any number of threads give the same values.
+ */
+inline uint64_t shift_seed(const uint64_t seed, const int shift);
+
+/**
+ * xoshiro256++ (Blackman & Vigna) running lanes independent streams side by side.
+ * The lanes are updated in lock step, which the compiler turns into vector instructions,
+ * so fill produces random numbers considerably faster than calling a single generator.
+ * Satisfies the requirements of a UniformRandomBitGenerator.
+ */
+class Xoshiro256pp
+{
+public:
+	typedef uint64_t result_type;
+	static constexpr int lanes = 4;
+
+	/**
+	 * All states are derived from seed by splitmix64.
+	 */
+	explicit Xoshiro256pp(const uint64_t seed = 0);
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+	result_type operator()();
+
+	/**
+	 * Write the next n random numbers to output. The sequence is the same as for n calls of operator().
+	 */
+	void fill(uint64_t* output, const std::size_t n);
+
+private:
+	void step(uint64_t* output);
+
+	uint64_t state[4][lanes];
+	uint64_t buffer[lanes];
+	int position;
+};
+
+/**
+ * The counter-based Philox4x32-10 (Salmon et al., 2011). Every output is a function
+ * of the key and its position only, so the numbers of any sample or repetition of
+ * any shift can be generated without generating the ones before them. The key is
+ * the seed and the position consists of the shift, a BootstrapStream, an index
+ * within the stream and the number of the block of 4 outputs.
+ * Satisfies the requirements of a UniformRandomBitGenerator.
+ */
+class Philox4x32
+{
+public:
+	typedef uint32_t result_type;
+
+	/**
+	 * Generator for the given shift, starting at the beginning of sample 0.
+	 */
+	explicit Philox4x32(const uint64_t seed = 0, const int shift = 0);
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+	result_type operator()();
+
+	/**
+	 * Continue with the first number of a stream.
+	 */
+	void seek(const BootstrapStream stream, const uint32_t index);
+
+	/**
+	 * Write the next n random numbers to output.
+	 */
+	void fill(uint32_t* output, const std::size_t n);
+
+	/**
+	 * Encrypt one counter: the four outputs of a block.
+	 */
+	static void block(const uint32_t counter[4], const uint32_t key[2], uint32_t* output);
+
+private:
+	uint32_t key[2];
+	uint32_t counter[4];
+	uint32_t buffer[4];
+	int position;
+};
+
+/**
+ * Make the following draws of rgen come from the given stream. Only Philox4x32
+ * has separate streams, all other generators simply continue their sequence.
+ */
+template<typename Rng>
+void bootstrap_stream(Rng& rgen, const BootstrapStream stream, const uint32_t index);
+inline void bootstrap_stream(Philox4x32& rgen, const BootstrapStream stream, const uint32_t index);
+
+/**
+ * Map the 32 random bits x to [0, range) with Lemire's multiply-and-shift.
+ * Returns false if x has to be rejected to keep the result unbiased.
+ */
+inline bool lemire_bounded(const uint32_t x, const uint32_t range, uint32_t& result);
+
+/**
+ * Draw n uniformly distributed integers of [0, range) into output.
+ * The generic version uses std::uniform_int_distribution.
+ */
+template<typename Rng, typename Integer>
+void draw_bounded(Rng& rgen, const std::size_t range, Integer* output, const std::size_t n);
+
+/**
+ * For xoshiro256++ the 64 bit numbers are generated in one batch and every one
+ * of them gives two 32 bit candidates for lemire_bounded.
+ */
+template<typename Integer>
+void draw_bounded(Xoshiro256pp& rgen, const std::size_t range, Integer* output, const std::size_t n);
+
+/**
+ * For Philox the blocks of four 32 bit numbers are the candidates of lemire_bounded.
+ */
+template<typename Integer>
+void draw_bounded(Philox4x32& rgen, const std::size_t range, Integer* output, const std::size_t n);
+
+/**
+ * draw_bounded with the 32 bit candidates of the words of the generator's fill,
+ * lowest bits first. Ranges beyond 2^32 go through std::uniform_int_distribution.
+ */
+template<typename Rng, typename Integer>
+void draw_bounded_lemire(Rng& rgen, const std::size_t range, Integer* output, const std::size_t n);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline const std::vector<std::string>& bootstrap_rng_names()
+{
+	static const std::vector<std::string> names {"mt19937", "xoshiro256pp", "philox"};
+	return names;
+}
+
+inline BootstrapRng bootstrap_rng_from_name(const std::string& name)
+{
+	const std::vector<std::string>& names = bootstrap_rng_names();
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		if (names[i] == name)
+			return static_cast<BootstrapRng>(i);
+	}
+	throw std::invalid_argument("Unknown random number generator: " + name);
+}
+
+inline uint64_t clock_seed()
+{
+	return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+}
+
+inline uint64_t shift_seed(const uint64_t seed, const int shift)
+{
+	// One round of splitmix64 on the seed combined with the shift.
+	uint64_t v = seed + 0x9e3779b97f4a7c15ULL * (uint64_t(uint32_t(shift)) + 1);
+	v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	v = (v ^ (v >> 27)) * 0x94d049bb133111ebULL;
+	return v ^ (v >> 31);
+}
+
+inline Xoshiro256pp::Xoshiro256pp(const uint64_t seed)
+	: position(lanes)
+{
+	uint64_t z = seed;
+	for (int w = 0; w < 4; ++w)
+	{
+		for (int l = 0; l < lanes; ++l)
+		{
+			// splitmix64
+			z += 0x9e3779b97f4a7c15ULL;
+			uint64_t v = z;
+			v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			v = (v ^ (v >> 27)) * 0x94d049bb133111ebULL;
+			state[w][l] = v ^ (v >> 31);
+		}
+	}
+}
+
+inline void Xoshiro256pp::step(uint64_t* output)
+{
+	for (int l = 0; l < lanes; ++l)
+	{
+		const uint64_t sum = state[0][l] + state[3][l];
+		output[l] = ((sum << 23) | (sum >> 41)) + state[0][l];
+		const uint64_t t = state[1][l] << 17;
+		state[2][l] ^= state[0][l];
+		state[3][l] ^= state[1][l];
+		state[1][l] ^= state[2][l];
+		state[0][l] ^= state[3][l];
+		state[2][l] ^= t;
+		state[3][l] = (state[3][l] << 45) | (state[3][l] >> 19);
+	}
+}
+
+inline Xoshiro256pp::result_type Xoshiro256pp::operator()()
+{
+	if (position == lanes)
+	{
+		step(buffer);
+		position = 0;
+	}
+	return buffer[position++];
+}
+
+inline void Xoshiro256pp::fill(uint64_t* output, const std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i < n && position < lanes; ++i)
+		output[i] = buffer[position++];
+	for (; i + lanes <= n; i += lanes)
+		step(output + i);
+	for (; i < n; ++i)
+		output[i] = (*this)();
+}
+
+inline bool lemire_bounded(const uint32_t x, const uint32_t range, uint32_t& result)
+{
+	const uint64_t m = uint64_t(x) * range;
+	const uint32_t low = uint32_t(m);
+	result = uint32_t(m >> 32);
+	// Only the lowest (2^32 mod range) values of low are biased.
+	return low >= range || low >= uint32_t(-range) % range;
+}
+
+template<typename Rng, typename Integer>
+void draw_bounded(Rng& rgen, const std::size_t range, Integer* output, const std::size_t n)
+{
+	std::uniform_int_distribution<std::size_t> uniform(0, range - 1);
+	for (std::size_t i = 0; i < n; ++i)
+		output[i] = Integer(uniform(rgen));
+}
+
+inline Philox4x32::Philox4x32(const uint64_t seed, const int shift)
+	: key{uint32_t(seed), uint32_t(seed >> 32)},
+	  counter{0, 0, STREAM_SAMPLE, uint32_t(shift)},
+	  position(4)
+{
+}
+
+inline void Philox4x32::block(const uint32_t counter[4], const uint32_t key[2], uint32_t* output)
+{
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int round = 0; round < 10; ++round)
+	{
+		const uint64_t p0 = uint64_t(0xD2511F53u) * c0;
+		const uint64_t p1 = uint64_t(0xCD9E8D57u) * c2;
+		c0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+		c1 = uint32_t(p1);
+		c2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+		c3 = uint32_t(p0);
+		k0 += 0x9E3779B9u;
+		k1 += 0xBB67AE85u;
+	}
+	output[0] = c0;
+	output[1] = c1;
+	output[2] = c2;
+	output[3] = c3;
+}
+
+inline Philox4x32::result_type Philox4x32::operator()()
+{
+	if (position == 4)
+	{
+		block(counter, key, buffer);
+		++counter[0];
+		position = 0;
+	}
+	return buffer[position++];
+}
+
+inline void Philox4x32::seek(const BootstrapStream stream, const uint32_t index)
+{
+	counter[0] = 0;
+	counter[1] = index;
+	counter[2] = stream;
+	position = 4;
+}
+
+inline void Philox4x32::fill(uint32_t* output, const std::size_t n)
+{
+	std::size_t i = 0;
+	for (; i < n && position < 4; ++i)
+		output[i] = buffer[position++];
+	for (; i + 4 <= n; i += 4)
+	{
+		block(counter, key, output + i);
+		++counter[0];
+	}
+	for (; i < n; ++i)
+		output[i] = (*this)();
+}
+
+template<typename Rng>
+void bootstrap_stream(Rng&, const BootstrapStream, const uint32_t)
+{
+}
+
+inline void bootstrap_stream(Philox4x32& rgen, const BootstrapStream stream, const uint32_t index)
+{
+	rgen.seek(stream, index);
+}
+
+template<typename Integer>
+void draw_bounded(Xoshiro256pp& rgen, const std::size_t range, Integer* output, const std::size_t n)
+{
+	draw_bounded_lemire(rgen, range, output, n);
+}
+
+template<typename Integer>
+void draw_bounded(Philox4x32& rgen, const std::size_t range, Integer* output, const std::size_t n)
+{
+	draw_bounded_lemire(rgen, range, output, n);
+}
+
+template<typename Rng, typename Integer>
+void draw_bounded_lemire(Rng& rgen, const std::size_t range, Integer* output, const std::size_t n)
+{
+	typedef typename Rng::result_type Word;
+	const int halves = sizeof(Word) / sizeof(uint32_t);
+	if (range > std::numeric_limits<uint32_t>::max())
+	{
+		// More than 2^32 values do not fit the 32 bit candidates.
+		std::uniform_int_distribution<std::size_t> uniform(0, range - 1);
+		for (std::size_t i = 0; i < n; ++i)
+			output[i] = Integer(uniform(rgen));
+		return;
+	}
+	const uint32_t range32 = uint32_t(range);
+	const std::size_t block = 256;
+	Word random[block];
+	std::size_t i = 0;
+	while (i < n)
+	{
+		const std::size_t count = std::min(block, (n - i + halves - 1) / halves);
+		rgen.fill(random, count);
+		for (std::size_t j = 0; j < count; ++j)
+		{
+			for (int h = 0; h < halves && i < n; ++h)
+			{
+				uint32_t value;
+				if (lemire_bounded(uint32_t(uint64_t(random[j]) >> (32 * h)), range32, value))
+					output[i++] = Integer(value);
+			}
+		}
+	}
+}
@@ -0,0 +1,533 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Low level kernels for incrementing a flat, row-major 2D histogram H[x * binsY + y]
+ * with pairs of histogram indices.
+ *
+ * Consecutive samples of slowly varying signals often hit the same bin. Incrementing
+ * a single histogram then stalls on store-to-load forwarding since every increment
+ * depends on the previous one. The kernels spread consecutive samples over
+ * histogram_kernel_lanes interleaved sub-histograms in a scratch buffer and sum
+ * them up at the end. Indices outside of the bin range are redirected to an extra
+ * trash bin behind each sub-histogram so the inner loops are branchless.
+ *
+ * There is an AVX-512 variant (gather, conflict detection, scatter), an AVX2
+ * variant (vectorized bin calculation) and a portable scalar fallback. Which one is
+ * used is decided at compile time by the target architecture
+ * (see USE_NATIVE_ARCH in CMakeLists.txt).
+ * Without vector instructions, common bin shapes have scalar kernels with the numbers
+ * of bins as template parameters, which are chosen at runtime (see histogram_kernel_fixed_shapes).
+ * The vector kernels are faster than those, so they are only used for the fallback.
+ */
+
+/**
+ * Number of interleaved sub-histograms in the scratch buffer.
+ */
+constexpr int histogram_kernel_lanes {4};
+
+/**
+ * Largest number of samples the kernels pass to the int sub-histograms at once.
+ * The histogram H itself may use wider counters (see Histogram2d).
+ */
+constexpr std::size_t histogram_kernel_max_block {std::size_t(std::numeric_limits<int>::max())};
+
+/**
+ * Largest number of ints increment_histogram_2d_fixed keeps on the stack: the sub-histograms
+ * of 32x32 bins, about 16 KiB.
+ */
+constexpr std::size_t histogram_kernel_max_stack_ints {histogram_kernel_lanes * (32 * 32 + 1)};
+
+/**
+ * Number of ints the scratch buffer of increment_histogram_2d needs.
+ */
+inline std::size_t histogram_kernel_scratch_size(const int binsX, const int binsY);
+
+/**
+ * Check if it is worth using the sub-histograms for this many samples; otherwise
+ * zeroing and reducing the scratch buffer takes longer than the increments.
+ */
+inline bool histogram_kernel_use_lanes(const int binsX, const int binsY, const std::size_t size);
+
+/**
+ * Increment the histogram H at all index pairs (X[i], Y[i]) with i in [0, size).
+ * If one of the indices is not smaller than the corresponding bin number
+ * no insertion takes place.
+ * @param H Row-major histogram of size binsX * binsY with counters of type Count.
+ * @param scratch Buffer of at least histogram_kernel_scratch_size(binsX, binsY) ints.
+ *        It is only used if histogram_kernel_use_lanes is true and might be nullptr otherwise.
+ * @return Number of inserted pairs.
+ */
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d(Count* H, const int binsX, const int binsY,
+		const Index* X, const Index* Y, const std::size_t size, int* scratch);
+
+/**
+ * Portable variant of increment_histogram_2d without any vector instructions.
+ */
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_scalar(Count* H, const int binsX, const int binsY,
+		const Index* X, const Index* Y, const std::size_t size, int* scratch);
+
+/**
+ * A shape of binsX x binsY bins known at compile time.
+ */
+template<int BinsX, int BinsY>
+struct HistogramShape {};
+
+/**
+ * A list of HistogramShape.
+ */
+template<typename... Shapes>
+struct HistogramShapes {};
+
+/**
+ * Bin shapes for which the scalar fallback of increment_histogram_2d uses increment_histogram_2d_fixed.
+ * Larger ones (64x64 takes 64 KiB) would not fit on the stack.
+ */
+typedef HistogramShapes<
+	HistogramShape<4, 4>, HistogramShape<8, 8>, HistogramShape<10, 10>,
+	HistogramShape<16, 16>, HistogramShape<32, 32>,
+	HistogramShape<4, 8>, HistogramShape<8, 4>, HistogramShape<8, 16>,
+	HistogramShape<16, 8>, HistogramShape<16, 32>, HistogramShape<32, 16>
+> histogram_kernel_fixed_shapes;
+
+/**
+ * Variant of increment_histogram_2d for BinsX x BinsY bins known at compile time.
+ * The sub-histograms are a fixed-size array on the stack instead of the scratch buffer,
+ * and the calculation of the bins and the range checks only use constants.
+ * Their size is limited by histogram_kernel_max_stack_ints.
+ */
+template<int BinsX, int BinsY, typename Count, typename Index>
+std::size_t increment_histogram_2d_fixed(Count* H, const Index* X, const Index* Y, const std::size_t size);
+
+#if defined(__AVX2__)
+/**
+ * AVX2 variant of increment_histogram_2d for uint8_t, uint16_t and int indices.
+ * Bins of 8 samples at a time are calculated with vector instructions.
+ */
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_avx2(Count* H, const int binsX, const int binsY,
+		const Index* X, const Index* Y, const std::size_t size, int* scratch);
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+/**
+ * AVX-512 variant of increment_histogram_2d for uint8_t, uint16_t and int indices.
+ * 16 samples at a time are gathered, incremented and scattered back. Lanes hitting
+ * the same bin are resolved with conflict detection.
+ */
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_avx512(Count* H, const int binsX, const int binsY,
+		const Index* X, const Index* Y, const std::size_t size, int* scratch);
+#endif
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline std::size_t histogram_kernel_scratch_size(const int binsX, const int binsY)
+{
+	return histogram_kernel_lanes * (std::size_t(binsX) * binsY + 1);
+}
+
+inline bool histogram_kernel_use_lanes(const int binsX, const int binsY, const std::size_t size)
+{
+	return size >= 2 * histogram_kernel_scratch_size(binsX, binsY);
+}
+
+/**
+ * Add up all sub-histograms in scratch and add the sum to H.
+ */
+template<typename Count>
+inline void reduce_histogram_lanes(Count* H, const std::size_t cells, const int* scratch)
+{
+	const std::size_t stride = cells + 1;
+	for (std::size_t i = 0; i < cells; ++i)
+	{
+		Count sum = 0;
+		for (int lane = 0; lane < histogram_kernel_lanes; ++lane)
+		{
+			sum += scratch[lane * stride + i];
+		}
+		H[i] += sum;
+	}
+}
+
+/**
+ * Number of set bits of a (vector compare) mask.
+ */
+inline int mask_popcount(uint32_t v)
+{
+	v = v - ((v >> 1) & 0x55555555u);
+	v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+	return int((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+/**
+ * Bin of a single pair of indices or `cells` (the trash bin) if it is out of range.
+ */
+template<typename Index>
+inline std::size_t histogram_kernel_cell(const Index x, const Index y,
+	const int binsX, const int binsY, const std::size_t cells)
+{
+	return (x >= 0 && x < binsX && y >= 0 && y < binsY)
+		? std::size_t(x) * binsY + y
+		: cells;
+}
+
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_scalar(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch)
+{
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	if (!histogram_kernel_use_lanes(binsX, binsY, size))
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			if (X[i] >= 0 && X[i] < binsX && Y[i] >= 0 && Y[i] < binsY)
+			{
+				++H[std::size_t(X[i]) * binsY + Y[i]];
+				++count;
+			}
+		}
+		return count;
+	}
+	const std::size_t stride = cells + 1;
+	std::fill(scratch, scratch + histogram_kernel_scratch_size(binsX, binsY), 0);
+	int* lane0 = scratch;
+	int* lane1 = scratch + stride;
+	int* lane2 = scratch + 2 * stride;
+	int* lane3 = scratch + 3 * stride;
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4)
+	{
+		++lane0[histogram_kernel_cell(X[i],     Y[i],     binsX, binsY, cells)];
+		++lane1[histogram_kernel_cell(X[i + 1], Y[i + 1], binsX, binsY, cells)];
+		++lane2[histogram_kernel_cell(X[i + 2], Y[i + 2], binsX, binsY, cells)];
+		++lane3[histogram_kernel_cell(X[i + 3], Y[i + 3], binsX, binsY, cells)];
+	}
+	for (; i < size; ++i)
+	{
+		++lane0[histogram_kernel_cell(X[i], Y[i], binsX, binsY, cells)];
+	}
+	std::size_t trash = 0;
+	for (int lane = 0; lane < histogram_kernel_lanes; ++lane)
+	{
+		trash += scratch[lane * stride + cells];
+	}
+	reduce_histogram_lanes(H, cells, scratch);
+	return size - trash;
+}
+
+#if defined(__AVX2__)
+inline __m256i load8_epi32(const uint8_t* p)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+inline __m256i load8_epi32(const uint16_t* p)
+{
+	return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p));
+}
+
+inline __m256i load8_epi32(const int* p)
+{
+	return _mm256_loadu_si256((const __m256i*)p);
+}
+
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_avx2(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch)
+{
+	if (!histogram_kernel_use_lanes(binsX, binsY, size))
+		return increment_histogram_2d_scalar(H, binsX, binsY, X, Y, size, scratch);
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	const int stride = int(cells + 1);
+	std::fill(scratch, scratch + histogram_kernel_scratch_size(binsX, binsY), 0);
+	// Lane j of a vector increments sub-histogram j % 4.
+	const __m256i lane_offset = _mm256_setr_epi32(
+		0, stride, 2 * stride, 3 * stride, 0, stride, 2 * stride, 3 * stride);
+	const __m256i trash = _mm256_add_epi32(lane_offset, _mm256_set1_epi32(int(cells)));
+	const __m256i maxX = _mm256_set1_epi32(binsX - 1);
+	const __m256i maxY = _mm256_set1_epi32(binsY - 1);
+	const __m256i vbinsY = _mm256_set1_epi32(binsY);
+	alignas(32) int offsets[8];
+	std::size_t invalid = 0;
+	std::size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		__m256i x = load8_epi32(X + i);
+		__m256i y = load8_epi32(Y + i);
+		// Unsigned x <= binsX - 1 also rejects negative values.
+		__m256i valid = _mm256_and_si256(
+			_mm256_cmpeq_epi32(_mm256_min_epu32(x, maxX), x),
+			_mm256_cmpeq_epi32(_mm256_min_epu32(y, maxY), y));
+		__m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(x, vbinsY), y);
+		cell = _mm256_blendv_epi8(trash, _mm256_add_epi32(cell, lane_offset), valid);
+		_mm256_store_si256((__m256i*)offsets, cell);
+		invalid += 8 - mask_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(valid)));
+		++scratch[offsets[0]];
+		++scratch[offsets[1]];
+		++scratch[offsets[2]];
+		++scratch[offsets[3]];
+		++scratch[offsets[4]];
+		++scratch[offsets[5]];
+		++scratch[offsets[6]];
+		++scratch[offsets[7]];
+	}
+	// The few remaining pairs go to the first sub-histogram.
+	for (; i < size; ++i)
+	{
+		const std::size_t cell = histogram_kernel_cell(X[i], Y[i], binsX, binsY, cells);
+		invalid += cell == cells;
+		++scratch[cell];
+	}
+	reduce_histogram_lanes(H, cells, scratch);
+	return size - invalid;
+}
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+inline __m512i load16_epi32(const uint8_t* p)
+{
+	return _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)p));
+}
+
+inline __m512i load16_epi32(const uint16_t* p)
+{
+	return _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)p));
+}
+
+inline __m512i load16_epi32(const int* p)
+{
+	return _mm512_loadu_si512((const void*)p);
+}
+
+/**
+ * Number of set bits in each 32 bit lane.
+ */
+inline __m512i popcount16_epi32(__m512i v)
+{
+#if defined(__AVX512VPOPCNTDQ__)
+	return _mm512_popcnt_epi32(v);
+#else
+	v = _mm512_sub_epi32(v, _mm512_and_si512(_mm512_srli_epi32(v, 1), _mm512_set1_epi32(0x55555555)));
+	v = _mm512_add_epi32(_mm512_and_si512(v, _mm512_set1_epi32(0x33333333)),
+		_mm512_and_si512(_mm512_srli_epi32(v, 2), _mm512_set1_epi32(0x33333333)));
+	v = _mm512_and_si512(_mm512_add_epi32(v, _mm512_srli_epi32(v, 4)), _mm512_set1_epi32(0x0F0F0F0F));
+	return _mm512_srli_epi32(_mm512_mullo_epi32(v, _mm512_set1_epi32(0x01010101)), 24);
+#endif
+}
+
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_avx512(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch)
+{
+	if (!histogram_kernel_use_lanes(binsX, binsY, size))
+		return increment_histogram_2d_scalar(H, binsX, binsY, X, Y, size, scratch);
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	const int stride = int(cells + 1);
+	std::fill(scratch, scratch + histogram_kernel_scratch_size(binsX, binsY), 0);
+	// Lane j of a vector increments sub-histogram j % 4.
+	const __m512i lane_offset = _mm512_setr_epi32(
+		0, stride, 2 * stride, 3 * stride, 0, stride, 2 * stride, 3 * stride,
+		0, stride, 2 * stride, 3 * stride, 0, stride, 2 * stride, 3 * stride);
+	const __m512i trash = _mm512_add_epi32(lane_offset, _mm512_set1_epi32(int(cells)));
+	const __m512i vbinsX = _mm512_set1_epi32(binsX);
+	const __m512i vbinsY = _mm512_set1_epi32(binsY);
+	const __m512i one = _mm512_set1_epi32(1);
+	std::size_t invalid = 0;
+	std::size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m512i x = load16_epi32(X + i);
+		__m512i y = load16_epi32(Y + i);
+		__mmask16 valid = _mm512_cmplt_epu32_mask(x, vbinsX) & _mm512_cmplt_epu32_mask(y, vbinsY);
+		__m512i cell = _mm512_add_epi32(_mm512_mullo_epi32(x, vbinsY), y);
+		cell = _mm512_mask_blend_epi32(valid, trash, _mm512_add_epi32(cell, lane_offset));
+		invalid += 16 - mask_popcount(valid);
+		// Each lane adds the number of preceding lanes with the same bin (plus itself).
+		// Scatter writes overlapping lanes in order, so the last one with the
+		// highest count wins.
+		__m512i conflicts = _mm512_conflict_epi32(cell);
+		__m512i increment = _mm512_add_epi32(popcount16_epi32(conflicts), one);
+		__m512i counts = _mm512_i32gather_epi32(cell, (const void*)scratch, 4);
+		_mm512_i32scatter_epi32((void*)scratch, cell, _mm512_add_epi32(counts, increment), 4);
+	}
+	// The few remaining pairs go to the first sub-histogram.
+	for (; i < size; ++i)
+	{
+		const std::size_t cell = histogram_kernel_cell(X[i], Y[i], binsX, binsY, cells);
+		invalid += cell == cells;
+		++scratch[cell];
+	}
+	reduce_histogram_lanes(H, cells, scratch);
+	return size - invalid;
+}
+#endif
+
+template<int BinsX, int BinsY, typename Count, typename Index>
+std::size_t increment_histogram_2d_fixed(Count* H, const Index* X, const Index* Y, const std::size_t size)
+{
+	constexpr std::size_t cells = std::size_t(BinsX) * BinsY;
+	constexpr std::size_t stride = cells + 1;
+	static_assert(histogram_kernel_lanes * stride <= histogram_kernel_max_stack_ints,
+		"the sub-histograms of this shape do not fit on the stack");
+	if (!histogram_kernel_use_lanes(BinsX, BinsY, size))
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			const std::size_t cell = histogram_kernel_cell(X[i], Y[i], BinsX, BinsY, cells);
+			if (cell < cells)
+			{
+				++H[cell];
+				++count;
+			}
+		}
+		return count;
+	}
+	alignas(64) int lanes[histogram_kernel_lanes * stride] = {};
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4)
+	{
+		++lanes[             histogram_kernel_cell(X[i],     Y[i],     BinsX, BinsY, cells)];
+		++lanes[    stride + histogram_kernel_cell(X[i + 1], Y[i + 1], BinsX, BinsY, cells)];
+		++lanes[2 * stride + histogram_kernel_cell(X[i + 2], Y[i + 2], BinsX, BinsY, cells)];
+		++lanes[3 * stride + histogram_kernel_cell(X[i + 3], Y[i + 3], BinsX, BinsY, cells)];
+	}
+	for (; i < size; ++i)
+	{
+		++lanes[histogram_kernel_cell(X[i], Y[i], BinsX, BinsY, cells)];
+	}
+	std::size_t trash = 0;
+	for (int lane = 0; lane < histogram_kernel_lanes; ++lane)
+	{
+		trash += lanes[lane * stride + cells];
+	}
+	reduce_histogram_lanes(H, cells, lanes);
+	return size - trash;
+}
+
+/**
+ * Run increment_histogram_2d_fixed if (binsX, binsY) is one of the shapes.
+ * @return False if there is no kernel for this shape.
+ */
+template<typename Count, typename Index>
+inline bool increment_histogram_2d_fixed_shapes(Count*, const int, const int,
+	const Index*, const Index*, const std::size_t, std::size_t&, HistogramShapes<>)
+{
+	return false;
+}
+
+template<typename Count, typename Index, int BinsX, int BinsY, typename... Shapes>
+inline bool increment_histogram_2d_fixed_shapes(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, std::size_t& inserted,
+	HistogramShapes<HistogramShape<BinsX, BinsY>, Shapes...>)
+{
+	if (binsX == BinsX && binsY == BinsY)
+	{
+		inserted = increment_histogram_2d_fixed<BinsX, BinsY>(H, X, Y, size);
+		return true;
+	}
+	return increment_histogram_2d_fixed_shapes(H, binsX, binsY, X, Y, size, inserted, HistogramShapes<Shapes...>());
+}
+
+/**
+ * Scalar fallback: the kernel for the bin shape if there is one, else the generic one.
+ */
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_portable(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch)
+{
+	std::size_t inserted = 0;
+	if (increment_histogram_2d_fixed_shapes(H, binsX, binsY, X, Y, size, inserted, histogram_kernel_fixed_shapes()))
+		return inserted;
+	return increment_histogram_2d_scalar(H, binsX, binsY, X, Y, size, scratch);
+}
+
+/**
+ * Use the widest vector instructions available for the given index type.
+ */
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_vectorized(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch)
+{
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+	return increment_histogram_2d_avx512(H, binsX, binsY, X, Y, size, scratch);
+#elif defined(__AVX2__)
+	return increment_histogram_2d_avx2(H, binsX, binsY, X, Y, size, scratch);
+#else
+	return increment_histogram_2d_portable(H, binsX, binsY, X, Y, size, scratch);
+#endif
+}
+
+/**
+ * Index types which can be loaded by the vectorized kernels.
+ */
+template<typename Index>
+struct histogram_kernel_vectorized : std::false_type {};
+template<>
+struct histogram_kernel_vectorized<uint8_t> : std::true_type {};
+template<>
+struct histogram_kernel_vectorized<uint16_t> : std::true_type {};
+template<>
+struct histogram_kernel_vectorized<int> : std::true_type {};
+
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_block(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch, std::true_type)
+{
+	return increment_histogram_2d_vectorized(H, binsX, binsY, X, Y, size, scratch);
+}
+
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d_block(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch, std::false_type)
+{
+	return increment_histogram_2d_portable(H, binsX, binsY, X, Y, size, scratch);
+}
+
+template<typename Count, typename Index>
+std::size_t increment_histogram_2d(Count* H, const int binsX, const int binsY,
+	const Index* X, const Index* Y, const std::size_t size, int* scratch)
+{
+	// The sub-histograms count in int, so they must not see more than INT_MAX samples at once.
+	std::size_t inserted = 0;
+	for (std::size_t first = 0; first < size; first += histogram_kernel_max_block)
+	{
+		const std::size_t block = std::min(size - first, histogram_kernel_max_block);
+		inserted += increment_histogram_2d_block(H, binsX, binsY, X + first, Y + first, block, scratch,
+			histogram_kernel_vectorized<Index>());
+	}
+	return inserted;
+}
@@ -0,0 +1,132 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+/**
+ * Measures derived from the mutual information I and the entropies of the marginal
+ * and joint distributions of every shift (see the entropies of shifted_mutual_information).
+ */
+enum InformationMeasure
+{
+	MEASURE_ENTROPY_X,       // H(X)
+	MEASURE_ENTROPY_Y,       // H(Y)
+	MEASURE_JOINT_ENTROPY,   // H(X,Y)
+	MEASURE_NMI_X,           // I / H(X)
+	MEASURE_NMI_Y,           // I / H(Y)
+	MEASURE_NMI_SQRT,        // I / sqrt(H(X) H(Y))
+	MEASURE_NMI_JOINT,       // I / H(X,Y)
+	MEASURE_VARIATION        // Variation of information H(X,Y) - I
+};
+
+/**
+ * Names of all measures in the order of InformationMeasure (e.g. for the command line).
+ */
+inline const std::vector<std::string>& information_measure_names();
+
+/**
+ * Get the measure for one of the names in information_measure_names.
+ */
+inline InformationMeasure information_measure_from_name(const std::string& name);
+
+/**
+ * Calculate a measure of every shift.
+ * Normalized mutual information is 0 if its denominator is 0 (i.e. for constant data).
+ * @param mutual_information Uncorrected mutual information of every shift; the entropies
+ *   are plug-in estimates too, so only this keeps e.g. the variation of information non-negative.
+ * @param entropies H(X), H(Y) and H(X,Y) of every shift one after the other.
+ * @return Vector of the same size as mutual_information.
+ */
+template<typename T>
+std::vector<T> information_measure(const InformationMeasure measure,
+		const std::vector<T>& mutual_information, const std::vector<T>& entropies);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline const std::vector<std::string>& information_measure_names()
+{
+	static const std::vector<std::string> names {"entropy_x", "entropy_y", "joint_entropy",
+		"nmi_x", "nmi_y", "nmi_sqrt", "nmi_joint", "variation"};
+	return names;
+}
+
+inline InformationMeasure information_measure_from_name(const std::string& name)
+{
+	const std::vector<std::string>& names = information_measure_names();
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		if (names[i] == name)
+			return static_cast<InformationMeasure>(i);
+	}
+	throw std::invalid_argument("Unknown measure: " + name);
+}
+
+template<typename T>
+std::vector<T> information_measure(const InformationMeasure measure,
+	const std::vector<T>& mutual_information, const std::vector<T>& entropies)
+{
+	if (entropies.size() != 3 * mutual_information.size())
+		throw std::logic_error("There must be three entropies for every shift.");
+	std::vector<T> result(mutual_information.size());
+	for (std::size_t s = 0; s < result.size(); ++s)
+	{
+		const T mi = mutual_information[s];
+		const T hX = entropies[3 * s];
+		const T hY = entropies[3 * s + 1];
+		const T hXY = entropies[3 * s + 2];
+		T denominator = 1;
+		switch (measure)
+		{
+		case MEASURE_ENTROPY_X:
+			result[s] = hX;
+			continue;
+		case MEASURE_ENTROPY_Y:
+			result[s] = hY;
+			continue;
+		case MEASURE_JOINT_ENTROPY:
+			result[s] = hXY;
+			continue;
+		case MEASURE_VARIATION:
+			result[s] = std::max(hXY - mi, T(0));
+			continue;
+		case MEASURE_NMI_X:
+			denominator = hX;
+			break;
+		case MEASURE_NMI_Y:
+			denominator = hY;
+			break;
+		case MEASURE_NMI_SQRT:
+			denominator = std::sqrt(hX * hY);
+			break;
+		case MEASURE_NMI_JOINT:
+			denominator = hXY;
+			break;
+		}
+		result[s] = denominator > 0 ? mi / denominator : T(0);
+	}
+	return result;
+}
@@ -0,0 +1,300 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include "Histogram2d.h"
+#include "utilities.h"
+
+/**
+ * Number of points of the coarse grid if the step of the lag search is chosen automatically.
+ */
+constexpr int lag_search_coarse_points {200};
+
+/**
+ * A local maximum of the mutual information over the shifts.
+ */
+template<typename T>
+struct LagPeak
+{
+	int shift;
+	T mutual_information;
+};
+
+/**
+ * Result of find_mutual_information_peaks.
+ */
+template<typename T>
+struct LagSearchResult
+{
+	// Peaks sorted by decreasing mutual information.
+	std::vector< LagPeak<T> > peaks;
+	// All evaluated shifts in increasing order and their mutual information.
+	std::vector<int> shifts;
+	std::vector<T> values;
+};
+
+/**
+ * Search the shifts with the largest mutual information without evaluating every shift.
+ * First the shifts from shift_from to shift_to are evaluated with coarse_step. Then each of the
+ * top_k local maxima of this grid is refined by comparing it with its neighbours at half the
+ * distance, down to a distance of 1, and at last climbing to the next local maximum
+ * with a step of 1. Peaks narrower than coarse_step may be missed.
+ * @param top_k Maximum number of peaks to return.
+ * @param coarse_step Step of the coarse grid; if 0 it is chosen to give about
+ *        lag_search_coarse_points points. (default: 0)
+ * @param engine Strategy for the coarse grid. (default: ENGINE_AUTO)
+ * Other parameters are the same as for shifted_mutual_information.
+ * @return The peaks and all evaluated points.
+ */
+template<typename T, typename Iterator>
+LagSearchResult<T> find_mutual_information_peaks(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	const int top_k,
+	const int coarse_step = 0,
+	const ShiftEngine engine = ENGINE_AUTO);
+
+/**
+ * Helper for find_mutual_information_peaks with a specific index type.
+ */
+template<typename Index, typename T, typename Iterator>
+LagSearchResult<T> find_mutual_information_peaks_binned(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	const int top_k, const int coarse_step, const ShiftEngine engine);
+
+/**
+ * Evaluate the mutual information of the given shifts in parallel and add it to evaluated.
+ * Shifts which are already in evaluated are skipped.
+ */
+template<typename T, typename Index>
+void evaluate_shifts(std::map<int, T>& evaluated, std::vector<int> shifts,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size);
+
+/**
+ * evaluate_shifts with histograms counting in Count.
+ */
+template<typename Count, typename T, typename Index>
+void evaluate_shifts_with_counts(std::map<int, T>& evaluated, std::vector<int> shifts,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename T, typename Iterator>
+LagSearchResult<T> find_mutual_information_peaks(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	const int top_k,
+	const int coarse_step /* 0 */,
+	const ShiftEngine engine /* ENGINE_AUTO */)
+{
+	const std::size_t sizeX = std::distance(beginX, endX);
+	const std::size_t sizeY = std::distance(beginY, endY);
+	check_shifted_mutual_information(sizeX, sizeY, shift_from, shift_to,
+		binsX, binsY, minX, maxX, minY, maxY, 1);
+	if (top_k < 1)
+		throw std::invalid_argument("top_k must be greater or equal 1.");
+	if (coarse_step < 0)
+		throw std::invalid_argument("coarse_step must not be negative.");
+	switch (index_width(std::max(binsX, binsY)))
+	{
+	case 1:
+		return find_mutual_information_peaks_binned<uint8_t>(shift_from, shift_to, binsX, binsY,
+			minX, maxX, minY, maxY, beginX, endX, beginY, endY, top_k, coarse_step, engine);
+	case 2:
+		return find_mutual_information_peaks_binned<uint16_t>(shift_from, shift_to, binsX, binsY,
+			minX, maxX, minY, maxY, beginX, endX, beginY, endY, top_k, coarse_step, engine);
+	default:
+		return find_mutual_information_peaks_binned<int>(shift_from, shift_to, binsX, binsY,
+			minX, maxX, minY, maxY, beginX, endX, beginY, endY, top_k, coarse_step, engine);
+	}
+}
+
+template<typename Index, typename T, typename Iterator>
+LagSearchResult<T> find_mutual_information_peaks_binned(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	const int top_k, const int coarse_step, const ShiftEngine engine)
+{
+	const std::vector<Index> X = calculate_indices_1d<Index>(binsX, minX, maxX, beginX, endX);
+	const std::vector<Index> Y = calculate_indices_1d<Index>(binsY, minY, maxY, beginY, endY);
+	const std::size_t size = X.size();
+	const int step = coarse_step > 0 ? coarse_step
+		: std::max(1, (shift_to - shift_from) / lag_search_coarse_points);
+	// Coarse grid, always including shift_to.
+	const int nr_coarse = (shift_to - shift_from) / step + 1;
+	std::vector<T> coarse(nr_coarse);
+	shifted_mutual_information_from_indices(shift_from, shift_from + (nr_coarse - 1) * step,
+		binsX, binsY, minX, maxX, minY, maxY,
+		X.data(), X.data() + size, Y.data(), Y.data() + size, step, coarse.data(), engine);
+	std::map<int, T> evaluated;
+	for (int k = 0; k < nr_coarse; ++k)
+	{
+		evaluated[shift_from + k * step] = coarse[k];
+	}
+	evaluate_shifts(evaluated, std::vector<int>{shift_to}, binsX, binsY, minX, maxX, minY, maxY,
+		X.data(), Y.data(), size);
+	// Local maxima of the coarse grid are the candidates.
+	std::vector< LagPeak<T> > candidates;
+	for (auto it = evaluated.begin(); it != evaluated.end(); ++it)
+	{
+		auto next = std::next(it);
+		const bool above_previous = it == evaluated.begin() || std::prev(it)->second <= it->second;
+		const bool above_next = next == evaluated.end() || next->second <= it->second;
+		if (above_previous && above_next)
+			candidates.push_back(LagPeak<T>{it->first, it->second});
+	}
+	auto by_value = [](const LagPeak<T>& a, const LagPeak<T>& b) {
+		return a.mutual_information > b.mutual_information
+			|| (a.mutual_information == b.mutual_information && a.shift < b.shift);
+	};
+	std::sort(candidates.begin(), candidates.end(), by_value);
+	candidates.resize(std::min(candidates.size(), std::size_t(top_k)));
+	// Halve the distance to the neighbours of all candidates at once.
+	for (int distance = step / 2; distance > 0; distance /= 2)
+	{
+		std::vector<int> shifts;
+		for (const LagPeak<T>& candidate : candidates)
+		{
+			if (candidate.shift - distance >= shift_from)
+				shifts.push_back(candidate.shift - distance);
+			if (candidate.shift + distance <= shift_to)
+				shifts.push_back(candidate.shift + distance);
+		}
+		evaluate_shifts(evaluated, shifts, binsX, binsY, minX, maxX, minY, maxY, X.data(), Y.data(), size);
+		for (LagPeak<T>& candidate : candidates)
+		{
+			for (const int shift : {candidate.shift - distance, candidate.shift + distance})
+			{
+				auto it = evaluated.find(shift);
+				if (it != evaluated.end() && it->second > candidate.mutual_information)
+					candidate = LagPeak<T>{shift, it->second};
+			}
+		}
+	}
+	// Climb to a local maximum with step 1.
+	bool moved = true;
+	while (moved)
+	{
+		std::vector<int> shifts;
+		for (const LagPeak<T>& candidate : candidates)
+		{
+			if (candidate.shift > shift_from)
+				shifts.push_back(candidate.shift - 1);
+			if (candidate.shift < shift_to)
+				shifts.push_back(candidate.shift + 1);
+		}
+		evaluate_shifts(evaluated, shifts, binsX, binsY, minX, maxX, minY, maxY, X.data(), Y.data(), size);
+		moved = false;
+		for (LagPeak<T>& candidate : candidates)
+		{
+			for (const int shift : {candidate.shift - 1, candidate.shift + 1})
+			{
+				auto it = evaluated.find(shift);
+				if (it != evaluated.end() && it->second > candidate.mutual_information)
+				{
+					candidate = LagPeak<T>{shift, it->second};
+					moved = true;
+				}
+			}
+		}
+	}
+	// Several candidates may end at the same peak.
+	LagSearchResult<T> result;
+	std::sort(candidates.begin(), candidates.end(), by_value);
+	for (const LagPeak<T>& candidate : candidates)
+	{
+		bool seen = false;
+		for (const LagPeak<T>& peak : result.peaks)
+		{
+			seen = seen || peak.shift == candidate.shift;
+		}
+		if (!seen)
+			result.peaks.push_back(candidate);
+	}
+	for (const auto& point : evaluated)
+	{
+		result.shifts.push_back(point.first);
+		result.values.push_back(point.second);
+	}
+	return result;
+}
+
+template<typename T, typename Index>
+void evaluate_shifts(std::map<int, T>& evaluated, std::vector<int> shifts,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size)
+{
+	if (needs_wide_counts(size))
+		evaluate_shifts_with_counts<long long>(evaluated, shifts, binsX, binsY, minX, maxX, minY, maxY, X, Y, size);
+	else
+		evaluate_shifts_with_counts<int>(evaluated, shifts, binsX, binsY, minX, maxX, minY, maxY, X, Y, size);
+}
+
+template<typename Count, typename T, typename Index>
+void evaluate_shifts_with_counts(std::map<int, T>& evaluated, std::vector<int> shifts,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size)
+{
+	std::sort(shifts.begin(), shifts.end());
+	shifts.erase(std::unique(shifts.begin(), shifts.end()), shifts.end());
+	shifts.erase(std::remove_if(shifts.begin(), shifts.end(),
+		[&evaluated](const int shift) { return evaluated.count(shift) > 0; }), shifts.end());
+	const int nr_shifts = int(shifts.size());
+	std::vector<T> values(nr_shifts);
+#pragma omp parallel for schedule(dynamic)
+	for (int s = 0; s < nr_shifts; ++s)
+	{
+		Histogram2d<T, Count> hist(binsX, binsY, minX, maxX, minY, maxY);
+		increment_shifted(hist, shifts[s], X, X + size, Y, Y + size);
+		values[s] = *hist.calculate_mutual_information();
+	}
+	for (int s = 0; s < nr_shifts; ++s)
+	{
+		evaluated[shifts[s]] = values[s];
+	}
+}
@@ -0,0 +1,214 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+/**
+ * How the read-only index arrays are placed on NUMA systems.
+ * Without libnuma (or on machines with a single node) all policies behave like NUMA_NONE.
+ */
+enum NumaPolicy
+{
+	NUMA_NONE,       // Leave memory wherever the operating system puts it.
+	NUMA_INTERLEAVE, // Interleave the pages over all nodes and spread the threads over the nodes.
+	NUMA_REPLICATE   // One copy per node; the threads of each node work on their own part of the shifts.
+};
+
+/**
+ * Names of the policies as used on the command line, in the order of NumaPolicy.
+ */
+inline const std::vector<std::string>& numa_policy_names();
+
+/**
+ * Get the policy for one of the names in numa_policy_names.
+ */
+inline NumaPolicy numa_policy_from_name(const std::string& name);
+
+/**
+ * Number of NUMA nodes the program may use; 1 if libnuma is not available.
+ */
+inline int numa_node_count();
+
+/**
+ * Restrict the calling thread to the CPUs of a node. Does nothing without libnuma.
+ */
+inline void numa_pin_thread(const int node);
+
+/**
+ * Let the calling thread run on the CPUs of all nodes again. Does nothing without libnuma.
+ */
+inline void numa_unpin_thread();
+
+/**
+ * Unpins all threads of a parallel region (see numa_unpin_thread) when it goes out of
+ * scope, also if an exception is thrown. Create it before pinning the threads of a team
+ * so neither the calling thread nor the pool of OpenMP threads stays on a node.
+ */
+class NumaTeamUnpin
+{
+public:
+	NumaTeamUnpin() = default;
+	~NumaTeamUnpin();
+
+private:
+	NumaTeamUnpin(const NumaTeamUnpin&) = delete;
+	NumaTeamUnpin& operator=(const NumaTeamUnpin&) = delete;
+};
+
+/**
+ * Special node for NumaArray: interleave the pages over all nodes.
+ */
+constexpr int numa_interleaved {-1};
+
+/**
+ * Read-only copy of an array placed on a NUMA node (or interleaved over all nodes).
+ * Without libnuma it is an ordinary copy on the heap.
+ */
+template<typename T>
+class NumaArray
+{
+public:
+	/**
+	 * @param node Node to allocate the memory on or numa_interleaved.
+	 */
+	NumaArray(const T* source, const std::size_t size, const int node);
+	~NumaArray();
+
+	const T* data() const;
+	std::size_t size() const;
+
+private:
+	NumaArray(const NumaArray&) = delete;
+	NumaArray& operator=(const NumaArray&) = delete;
+
+	T* buffer;
+	const std::size_t length;
+	bool from_libnuma;
+};
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline const std::vector<std::string>& numa_policy_names()
+{
+	static const std::vector<std::string> names {"none", "interleave", "replicate"};
+	return names;
+}
+
+inline NumaPolicy numa_policy_from_name(const std::string& name)
+{
+	const std::vector<std::string>& names = numa_policy_names();
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		if (names[i] == name)
+			return static_cast<NumaPolicy>(i);
+	}
+	throw std::invalid_argument("Unknown NUMA policy: " + name);
+}
+
+inline int numa_node_count()
+{
+#ifdef HAVE_LIBNUMA
+	if (numa_available() < 0)
+		return 1;
+	return std::max(numa_num_configured_nodes(), 1);
+#else
+	return 1;
+#endif
+}
+
+inline void numa_pin_thread(const int node)
+{
+#ifdef HAVE_LIBNUMA
+	if (numa_available() >= 0)
+		numa_run_on_node(node);
+#else
+	(void)node;
+#endif
+}
+
+inline void numa_unpin_thread()
+{
+#ifdef HAVE_LIBNUMA
+	if (numa_available() >= 0)
+		numa_run_on_node(-1);
+#endif
+}
+
+inline NumaTeamUnpin::~NumaTeamUnpin()
+{
+#pragma omp parallel
+	numa_unpin_thread();
+}
+
+template<typename T>
+NumaArray<T>::NumaArray(const T* source, const std::size_t size, const int node)
+	: buffer(nullptr), length(size), from_libnuma(false)
+{
+#ifdef HAVE_LIBNUMA
+	if (numa_available() >= 0 && size > 0)
+	{
+		void* memory = node == numa_interleaved
+			? numa_alloc_interleaved(size * sizeof(T))
+			: numa_alloc_onnode(size * sizeof(T), node);
+		buffer = static_cast<T*>(memory);
+		from_libnuma = buffer != nullptr;
+	}
+#else
+	(void)node;
+#endif
+	if (!buffer)
+		buffer = new T[size];
+	std::copy(source, source + size, buffer);
+}
+
+template<typename T>
+NumaArray<T>::~NumaArray()
+{
+#ifdef HAVE_LIBNUMA
+	if (from_libnuma)
+	{
+		numa_free(buffer, length * sizeof(T));
+		return;
+	}
+#endif
+	delete[] buffer;
+}
+
+template<typename T>
+const T* NumaArray<T>::data() const
+{
+	return buffer;
+}
+
+template<typename T>
+std::size_t NumaArray<T>::size() const
+{
+	return length;
+}
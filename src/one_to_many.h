@@ -0,0 +1,291 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "Histogram2d.h"
+#include "utilities.h"
+
+/**
+ * Number of targets sharing one pass over a chunk of the reference.
+ */
+constexpr int one_to_many_group_targets {4};
+
+/**
+ * Number of targets which are binned at the same time; bounds the memory for their indices.
+ */
+constexpr std::size_t one_to_many_batch_targets {256};
+
+/**
+ * Calculate the shifted mutual information of one reference against many targets.
+ * The reference is binned once. Each target is shifted against the reference like the second
+ * data vector in shifted_mutual_information. While a chunk of the reference is in the cache,
+ * it is used for a block of shifts (see tiled_engine_block_shifts) of a group of
+ * targets (see one_to_many_group_targets).
+ * @param minsY Minimum value for each target; if empty the minimum of each target is used.
+ * @param maxsY Maximum value for each target; if empty the maximum of each target is used.
+ * @return Matrix with targets.size() x nr_shifts values; the value at t * nr_shifts + k
+ *         belongs to target t and shift shift_from + k * shift_step.
+ * Other parameters are the same as for shifted_mutual_information.
+ */
+template<typename T, typename Iterator>
+std::vector<T> one_to_many_shifted_mutual_information(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const Iterator beginX, const Iterator endX,
+	const std::vector< std::vector<T> >& targets,
+	const std::vector<T>& minsY = std::vector<T>(),
+	const std::vector<T>& maxsY = std::vector<T>(),
+	const int shift_step = 1);
+
+/**
+ * Variant of one_to_many_shifted_mutual_information which loads the targets on demand, so that
+ * only the indices of one_to_many_batch_targets of them are held at once. The reference is
+ * binned once for all targets.
+ * @param nr_targets Number of targets.
+ * @param load_target Called as load_target(t, minY, maxY) for t in [0, nr_targets) in order. Returns
+ *        the data of target t (a std::vector<T> or a reference to one) and sets its range minY, maxY.
+ * @param store_rows Called as store_rows(first, last, rows) after each batch of targets, where rows
+ *        holds (last - first) x nr_shifts values like the result of one_to_many_shifted_mutual_information.
+ * Other parameters are the same as for one_to_many_shifted_mutual_information.
+ */
+template<typename T, typename Iterator, typename LoadTarget, typename StoreRows>
+void one_to_many_shifted_mutual_information_streamed(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const Iterator beginX, const Iterator endX,
+	const std::size_t nr_targets, LoadTarget load_target, StoreRows store_rows,
+	const int shift_step = 1);
+
+/**
+ * Helper for one_to_many_shifted_mutual_information_streamed with a specific index type.
+ */
+template<typename Index, typename T, typename Iterator, typename LoadTarget, typename StoreRows>
+void one_to_many_shifted_mutual_information_binned(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const Iterator beginX, const Iterator endX,
+	const std::size_t nr_targets, LoadTarget& load_target, StoreRows& store_rows,
+	const int shift_step);
+
+/**
+ * Helper for one_to_many_shifted_mutual_information after binning.
+ * @param Y Index arrays of the targets, each of the same size as X.
+ * @param minsY Minimum value for each target.
+ * @param maxsY Maximum value for each target.
+ * @param output Has to hold Y.size() x nr_shifts values.
+ * @tparam Count Counter type of the histograms (see needs_wide_counts).
+ */
+template<typename T, typename Index, typename Count = int>
+void one_to_many_shifted_mutual_information_from_indices(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const std::vector<T>& minsY, const std::vector<T>& maxsY,
+	const Index* X, const std::vector<const Index*>& Y, const std::size_t size,
+	const int shift_step,
+	T* output);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename T, typename Iterator>
+std::vector<T> one_to_many_shifted_mutual_information(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const Iterator beginX, const Iterator endX,
+	const std::vector< std::vector<T> >& targets,
+	const std::vector<T>& minsY /* empty */,
+	const std::vector<T>& maxsY /* empty */,
+	const int shift_step /* 1 */)
+{
+	if (targets.empty())
+		throw std::invalid_argument("There must be at least one target.");
+	if (!minsY.empty() && minsY.size() != targets.size())
+		throw std::invalid_argument("There must be one minimum for each target.");
+	if (!maxsY.empty() && maxsY.size() != targets.size())
+		throw std::invalid_argument("There must be one maximum for each target.");
+	const std::size_t size = std::distance(beginX, endX);
+	for (const std::vector<T>& target : targets)
+	{
+		// The ranges of the targets are checked when they are binned.
+		check_shifted_mutual_information(size, target.size(), shift_from, shift_to,
+			binsX, binsY, minX, maxX, T(0), T(1), shift_step);
+	}
+	const std::size_t nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	std::vector<T> result(targets.size() * nr_shifts);
+	one_to_many_shifted_mutual_information_streamed(shift_from, shift_to, binsX, binsY, minX, maxX,
+		beginX, endX, targets.size(),
+		[&](const std::size_t t, T& minY, T& maxY) -> const std::vector<T>&
+		{
+			auto minmax = std::minmax_element(targets[t].begin(), targets[t].end());
+			minY = minsY.empty() ? *minmax.first : minsY[t];
+			maxY = maxsY.empty() ? *minmax.second : maxsY[t];
+			return targets[t];
+		},
+		[&](const std::size_t first, const std::size_t last, const T* rows)
+		{
+			std::copy(rows, rows + (last - first) * nr_shifts, result.begin() + first * nr_shifts);
+		},
+		shift_step);
+	return result;
+}
+
+template<typename T, typename Iterator, typename LoadTarget, typename StoreRows>
+void one_to_many_shifted_mutual_information_streamed(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const Iterator beginX, const Iterator endX,
+	const std::size_t nr_targets, LoadTarget load_target, StoreRows store_rows,
+	const int shift_step /* 1 */)
+{
+	if (nr_targets == 0)
+		throw std::invalid_argument("There must be at least one target.");
+	switch (index_width(std::max(binsX, binsY)))
+	{
+	case 1:
+		one_to_many_shifted_mutual_information_binned<uint8_t>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, beginX, endX, nr_targets, load_target, store_rows, shift_step);
+		break;
+	case 2:
+		one_to_many_shifted_mutual_information_binned<uint16_t>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, beginX, endX, nr_targets, load_target, store_rows, shift_step);
+		break;
+	default:
+		one_to_many_shifted_mutual_information_binned<int>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, beginX, endX, nr_targets, load_target, store_rows, shift_step);
+	}
+}
+
+template<typename Index, typename T, typename Iterator, typename LoadTarget, typename StoreRows>
+void one_to_many_shifted_mutual_information_binned(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const Iterator beginX, const Iterator endX,
+	const std::size_t nr_targets, LoadTarget& load_target, StoreRows& store_rows,
+	const int shift_step)
+{
+	const std::vector<Index> X = calculate_indices_1d<Index>(binsX, minX, maxX, beginX, endX);
+	const std::size_t nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	std::vector<T> rows;
+	for (std::size_t first = 0; first < nr_targets; first += one_to_many_batch_targets)
+	{
+		const std::size_t last = std::min(first + one_to_many_batch_targets, nr_targets);
+		std::vector< std::vector<Index> > indices(last - first);
+		std::vector<const Index*> Y(last - first);
+		std::vector<T> batch_mins(last - first);
+		std::vector<T> batch_maxs(last - first);
+		for (std::size_t t = first; t < last; ++t)
+		{
+			const auto& target = load_target(t, batch_mins[t - first], batch_maxs[t - first]);
+			check_shifted_mutual_information(X.size(), target.size(), shift_from, shift_to,
+				binsX, binsY, minX, maxX, batch_mins[t - first], batch_maxs[t - first], shift_step);
+			indices[t - first] = calculate_indices_1d<Index>(binsY, batch_mins[t - first], batch_maxs[t - first],
+				target.begin(), target.end());
+			Y[t - first] = indices[t - first].data();
+		}
+		rows.resize((last - first) * nr_shifts);
+		if (needs_wide_counts(X.size()))
+			one_to_many_shifted_mutual_information_from_indices<T, Index, long long>(shift_from, shift_to,
+				binsX, binsY, minX, maxX, batch_mins, batch_maxs, X.data(), Y, X.size(), shift_step,
+				rows.data());
+		else
+			one_to_many_shifted_mutual_information_from_indices<T, Index, int>(shift_from, shift_to,
+				binsX, binsY, minX, maxX, batch_mins, batch_maxs, X.data(), Y, X.size(), shift_step,
+				rows.data());
+		store_rows(first, last, rows.data());
+	}
+}
+
+template<typename T, typename Index, typename Count>
+void one_to_many_shifted_mutual_information_from_indices(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX,
+	const std::vector<T>& minsY, const std::vector<T>& maxsY,
+	const Index* X, const std::vector<const Index*>& Y, const std::size_t size,
+	const int shift_step,
+	T* output)
+{
+	const int nr_targets = int(Y.size());
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const int nr_groups = (nr_targets - 1) / one_to_many_group_targets + 1;
+	const int nr_blocks = (nr_shifts - 1) / tiled_engine_block_shifts + 1;
+	const int nr_tasks = nr_groups * nr_blocks;
+	const long long n = size;
+#pragma omp parallel for schedule(dynamic)
+	for (int task = 0; task < nr_tasks; ++task)
+	{
+		const int first_target = (task / nr_blocks) * one_to_many_group_targets;
+		const int last_target = std::min(first_target + one_to_many_group_targets, nr_targets);
+		const int first = (task % nr_blocks) * tiled_engine_block_shifts;
+		const int last = std::min(first + tiled_engine_block_shifts, nr_shifts);
+		const int block_shifts = last - first;
+		// One histogram per target and shift of this task.
+		std::vector< std::unique_ptr<Histogram2d<T, Count>> > hists;
+		for (int t = first_target; t < last_target; ++t)
+		{
+			for (int s = first; s < last; ++s)
+			{
+				hists.emplace_back(new Histogram2d<T, Count>(binsX, binsY, minX, maxX, minsY[t], maxsY[t]));
+			}
+		}
+		for (long long chunk = 0; chunk < n; chunk += tiled_engine_chunk_size)
+		{
+			const long long chunk_end = std::min(chunk + (long long)tiled_engine_chunk_size, n);
+			for (int t = first_target; t < last_target; ++t)
+			{
+				for (int s = first; s < last; ++s)
+				{
+					// Shift i pairs X[k] with Y[k - i] for k in [max(0, i), n + min(0, i)).
+					const long long i = shift_from + (long long)s * shift_step;
+					const long long begin = std::max(chunk, std::max(0LL, i));
+					const long long end = std::min(chunk_end, n + std::min(0LL, i));
+					if (begin < end)
+					{
+						hists[(t - first_target) * block_shifts + s - first]->increment_cpu(X + begin, X + end,
+							Y[t] + (begin - i), Y[t] + (end - i));
+					}
+				}
+			}
+		}
+		for (int t = first_target; t < last_target; ++t)
+		{
+			for (int s = first; s < last; ++s)
+			{
+				output[std::size_t(t) * nr_shifts + s] =
+					*hists[(t - first_target) * block_shifts + s - first]->calculate_mutual_information();
+			}
+		}
+	}
+}
@@ -0,0 +1,181 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include "ISimpleFile.h"
+#include "ShiftedMutualInformationStream.h"
+#include "utilities.h"
+
+/**
+ * Smallest and largest value in a file, reading at most chunk_size values at once.
+ * @throws std::logic_error if the file is empty.
+ */
+template<typename T>
+std::pair<T, T> find_minmax_chunked(ISimpleFile<T>& file, const std::size_t chunk_size);
+
+/**
+ * Number of samples per chunk so that shifted_mutual_information_chunked uses
+ * at most memory_budget bytes (roughly; the histograms of all shifts and the
+ * max|shift| samples of history are accounted for as well).
+ * @throws std::invalid_argument if the budget does not even suffice for the histograms.
+ */
+template<typename T, typename Index>
+std::size_t chunk_size_for_budget(const std::size_t memory_budget,
+		const int nr_shifts, const int binsX, const int binsY, const std::size_t max_shift);
+
+/**
+ * Like shifted_mutual_information but for data that does not fit into memory:
+ * both files are read in chunks, binned and added to the histograms of all shifts
+ * (see ShiftedMutualInformationStream, which keeps the overlap of max|shift| samples).
+ * The results are exactly the same as for the whole data.
+ * Histograms count in long long, so there is no limit on the size of the files.
+ * The ranges of values must be known; see find_minmax_chunked.
+ * @param memory_budget Approximate maximum of memory to use in bytes.
+ * @return Vector of size (shift_to - shift_from) / shift_step + 1.
+ */
+template<typename T>
+std::vector<T> shifted_mutual_information_chunked(
+		ISimpleFile<T>& fileX, ISimpleFile<T>& fileY,
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const int shift_step, const std::size_t memory_budget);
+
+/**
+ * Helper for dispatching shifted_mutual_information_chunked to the narrowest index type.
+ */
+template<typename Index, typename T>
+std::vector<T> shifted_mutual_information_chunked_binned(
+		ISimpleFile<T>& fileX, ISimpleFile<T>& fileY,
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const int shift_step, const std::size_t memory_budget);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+template<typename T>
+std::pair<T, T> find_minmax_chunked(ISimpleFile<T>& file, const std::size_t chunk_size)
+{
+	std::vector<T> chunk;
+	std::pair<T, T> minmax;
+	bool empty = true;
+	file.rewind();
+	while (file.readChunk(chunk, chunk_size) > 0)
+	{
+		auto result = std::minmax_element(chunk.begin(), chunk.end());
+		if (empty)
+		{
+			minmax.first = *result.first;
+			minmax.second = *result.second;
+			empty = false;
+		}
+		else
+		{
+			minmax.first = std::min(minmax.first, *result.first);
+			minmax.second = std::max(minmax.second, *result.second);
+		}
+	}
+	file.rewind();
+	if (empty)
+		throw std::logic_error("Can not find minimum and maximum of an empty file.");
+	return minmax;
+}
+
+template<typename T, typename Index>
+std::size_t chunk_size_for_budget(const std::size_t memory_budget,
+	const int nr_shifts, const int binsX, const int binsY, const std::size_t max_shift)
+{
+	// Joint histogram (with 64-bit counts) and sub-histograms of the kernels for every shift.
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	const std::size_t histograms = std::size_t(nr_shifts)
+		* (cells * sizeof(long long) + histogram_kernel_scratch_size(binsX, binsY) * sizeof(int));
+	// The stream keeps up to twice the history before dropping it.
+	const std::size_t history = 2 * 2 * max_shift * sizeof(Index);
+	// Per sample of both series: the values (read in up to double precision) and their indices,
+	// once as new block and once in the history of the stream.
+	const std::size_t per_sample = 2 * (sizeof(T) + sizeof(double) + 2 * sizeof(Index));
+	if (memory_budget <= histograms + history + per_sample)
+		throw std::invalid_argument("Memory budget is too small for the histograms of all shifts.");
+	return (memory_budget - histograms - history) / per_sample;
+}
+
+template<typename T>
+std::vector<T> shifted_mutual_information_chunked(
+	ISimpleFile<T>& fileX, ISimpleFile<T>& fileY,
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const int shift_step, const std::size_t memory_budget)
+{
+	switch (index_width(std::max(binsX, binsY)))
+	{
+	case 1:
+		return shifted_mutual_information_chunked_binned<uint8_t>(fileX, fileY, shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY, shift_step, memory_budget);
+	case 2:
+		return shifted_mutual_information_chunked_binned<uint16_t>(fileX, fileY, shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY, shift_step, memory_budget);
+	default:
+		return shifted_mutual_information_chunked_binned<int>(fileX, fileY, shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY, shift_step, memory_budget);
+	}
+}
+
+template<typename Index, typename T>
+std::vector<T> shifted_mutual_information_chunked_binned(
+	ISimpleFile<T>& fileX, ISimpleFile<T>& fileY,
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const int shift_step, const std::size_t memory_budget)
+{
+	// The total size is not known in advance and files that need chunks are large anyway.
+	ShiftedMutualInformationStream<T, Index, long long> stream(shift_from, shift_to,
+		binsX, binsY, minX, maxX, minY, maxY, shift_step);
+	const std::size_t max_shift = std::max(std::abs(shift_from), std::abs(shift_to));
+	const std::size_t chunk_size = chunk_size_for_budget<T, Index>(memory_budget,
+		stream.getNrShifts(), binsX, binsY, max_shift);
+	std::vector<T> chunkX;
+	std::vector<T> chunkY;
+	fileX.rewind();
+	fileY.rewind();
+	while (true)
+	{
+		const std::size_t sizeX = fileX.readChunk(chunkX, chunk_size);
+		const std::size_t sizeY = fileY.readChunk(chunkY, chunk_size);
+		if (sizeX != sizeY)
+			throw std::logic_error("Containers referenced by iterators must have the same size.");
+		if (sizeX == 0)
+			break;
+		stream.append(chunkX.begin(), chunkX.end(), chunkY.begin(), chunkY.end());
+	}
+	check_shifted_mutual_information(stream.size(), stream.size(), shift_from, shift_to,
+		binsX, binsY, minX, maxX, minY, maxY, shift_step);
+	return stream.mutual_information();
+}
@@ -0,0 +1,769 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <complex>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Histogram2d.h"
+#include "NLogNTable.h"
+#include "bias_correction.h"
+#include "FFT.h"
+#include "BitPlanes.h"
+
+/**
+ * Different strategies for calculating the histograms of all shifts.
+ * All of them give exactly the same results.
+ */
+enum ShiftEngine
+{
+	ENGINE_AUTO,      // Choose an engine depending on the size of the problem.
+	ENGINE_PER_SHIFT, // One pass over the data for every shift.
+	ENGINE_TILED,     // One pass over cache-sized chunks of the data for a block of shifts.
+	ENGINE_FFT,       // Cross-correlation of the bins with FFTs for all shifts at once.
+	ENGINE_BITPLANE   // Popcounts of bit planes of the bins; only for few bins.
+};
+
+/**
+ * Number of adjacent shifts the tiled engine processes during one pass over the data.
+ */
+constexpr int tiled_engine_block_shifts {16};
+
+/**
+ * Number of samples per chunk of the tiled engine. The chunk of the first index array and
+ * the corresponding part of the second one stay in the cache while all shifts
+ * of a block are processed.
+ */
+constexpr std::size_t tiled_engine_chunk_size {16384};
+
+/**
+ * Smallest number of samples worth a task of its own when single shifts
+ * are split across threads.
+ */
+constexpr std::size_t split_shift_min_samples {std::size_t(1) << 16};
+
+/**
+ * Largest number of bins per axis supported by the bit-plane engine.
+ */
+constexpr int bitplane_engine_max_bins {16};
+
+/**
+ * Number of 64-bit words of each plane the bit-plane engine shifts at once.
+ * The shifted planes of the second data series stay in the L1 cache.
+ */
+constexpr std::size_t bitplane_engine_block_words {256};
+
+/**
+ * Roughly how many joint counts the bit-plane engine updates (for 64 samples each)
+ * in the time a histogram is incremented by 64 samples.
+ */
+constexpr double bitplane_engine_cells_per_increment {
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+	256.
+#elif defined(__POPCNT__)
+	96.
+#else
+	32.
+#endif
+};
+
+/**
+ * ENGINE_AUTO only picks the FFT engine if its buffers take at most this many bytes.
+ */
+constexpr double fft_engine_max_bytes {double(std::size_t(1) << 30)};
+
+/**
+ * Names of the engines as used on the command line, in the order of ShiftEngine.
+ */
+inline const std::vector<std::string>& shift_engine_names();
+
+/**
+ * Get the engine for one of the names in shift_engine_names.
+ */
+inline ShiftEngine shift_engine_from_name(const std::string& name);
+
+/**
+ * Bytes the FFT engine allocates: the spectra of the Y bins, the transforms of each
+ * thread and the joint counts of all shifts (64-bit if needs_wide_counts).
+ */
+inline double fft_engine_bytes(const int nr_shifts, const std::size_t size,
+		const int binsX, const int binsY, const std::size_t max_shift);
+
+/**
+ * Pick an engine for ENGINE_AUTO.
+ * @param nr_shifts Number of shifts to calculate.
+ * @param size Number of samples in each index array.
+ * @param max_shift Largest absolute value of all shifts.
+ */
+inline ShiftEngine choose_shift_engine(const int nr_shifts, const std::size_t size,
+		const int binsX, const int binsY, const std::size_t max_shift);
+
+/**
+ * Number of threads the engines run with (1 without OpenMP).
+ */
+inline int shift_engine_threads();
+
+/**
+ * Into how many chunks the data of every shift is split. With at least as many shifts
+ * as threads each shift is a task of its own. With fewer shifts, each is split
+ * into chunks (of at least split_shift_min_samples samples) so all threads get work.
+ */
+inline int chunks_per_shift(const int nr_shifts, const std::size_t size, const int nr_threads);
+
+/**
+ * Check if histograms of this many samples need 64-bit counters (long long)
+ * because int counts might overflow.
+ */
+inline bool needs_wide_counts(const std::size_t size);
+
+/**
+ * Increment a histogram with all pairs of indices that overlap when the second
+ * index container is shifted against the first one by `shift`
+ * (see shifted_mutual_information for the direction of the shift).
+ * Both containers must have the same size which must be greater than |shift|.
+ */
+template<typename T, typename Count, typename Iterator>
+void increment_shifted(Histogram2d<T, Count>& hist, const int shift,
+		const Iterator beginX, const Iterator endX,
+		const Iterator beginY, const Iterator endY);
+
+/**
+ * Store the results of the histogram of shift number s in the outputs of an engine
+ * (see shifted_mutual_information_per_shift); raw and entropies may be nullptr.
+ */
+template<typename T, typename Count>
+void store_shift_result(Histogram2d<T, Count>& hist, const int s,
+		T* output, const BiasCorrection correction, T* raw, T* entropies);
+
+/**
+ * Same as above for the joint counts H of a shift.
+ * @param hX Buffer of size binsX for the marginal histogram of X.
+ * @param hY Buffer of size binsY for the marginal histogram of Y.
+ */
+template<typename T, typename Count>
+void store_shift_result(const Count* H, const int binsX, const int binsY, Count* hX, Count* hY, const int s,
+		T* output, const BiasCorrection correction, T* raw, T* entropies);
+
+/**
+ * Calculate the mutual information for each shift with one pass over the data per shift.
+ * Each thread processes a contiguous block of shifts and keeps one single
+ * Histogram2d for all of them which is reset between shifts.
+ * If there are fewer shifts than threads, the shifts are additionally split into
+ * chunks (see chunks_per_shift) whose partial histograms are summed pairwise in a tree.
+ * Arguments are not checked here; see shifted_mutual_information.
+ * @param X Histogram indices of the first data series.
+ * @param Y Histogram indices of the second data series.
+ * @param size Number of indices in X and in Y.
+ * @param output A pointer to a vector of size (shift_to - shift_from) / shift_step + 1
+ * @param correction (Optional) Subtract this estimate of the bias from every value (see mutual_information_bias).
+ * @param raw (Optional) Receives the uncorrected values; same size as output.
+ * @param entropies (Optional) Receives H(X), H(Y) and H(X,Y) of every shift one after the other,
+ *   so it has to hold three times as many values as output.
+ * @tparam Count Counter type of the histograms; see needs_wide_counts. All engines have it.
+ */
+template<typename T, typename Index, typename Count = int>
+void shifted_mutual_information_per_shift(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* X, const Index* Y, const std::size_t size,
+		const int shift_step,
+		T* output,
+		const BiasCorrection correction = BIAS_NONE,
+		T* raw = nullptr,
+		T* entropies = nullptr);
+
+/**
+ * Calculate the mutual information for blocks of tiled_engine_block_shifts adjacent
+ * shifts at once. The data is split into chunks of tiled_engine_chunk_size samples;
+ * each chunk is loaded from memory once and then added to the histograms of all
+ * shifts of the block while it is still in the cache.
+ * Parameters are the same as for shifted_mutual_information_per_shift.
+ */
+template<typename T, typename Index, typename Count = int>
+void shifted_mutual_information_tiled(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* X, const Index* Y, const std::size_t size,
+		const int shift_step,
+		T* output,
+		const BiasCorrection correction = BIAS_NONE,
+		T* raw = nullptr,
+		T* entropies = nullptr);
+
+
+/**
+ * Calculate the joint histograms of all shifts at once. For every pair of bins (bx, by)
+ * the joint count as a function of the shift is the cross-correlation of the indicator
+ * sequences [X[k] == bx] and [Y[k] == by], which is computed with zero-padded FFTs.
+ * Two real sequences are always packed into one complex transform.
+ * The runtime hardly depends on the number of shifts but grows with binsX * binsY,
+ * so this is best for few bins and wide ranges of shifts.
+ * Marginal counts of each shift are the sums over the rows and columns of its joint counts.
+ * Parameters are the same as for shifted_mutual_information_per_shift.
+ */
+template<typename T, typename Index, typename Count = int>
+void shifted_mutual_information_fft(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* X, const Index* Y, const std::size_t size,
+		const int shift_step,
+		T* output,
+		const BiasCorrection correction = BIAS_NONE,
+		T* raw = nullptr,
+		T* entropies = nullptr);
+
+/**
+ * Fill z with the indicator sequences of two bins, [indices[k] == bin1] as real
+ * and [indices[k] == bin2] as imaginary part, and zero-pad it to its full size.
+ * @param has_bin2 If false, the imaginary part is zero.
+ */
+template<typename Index>
+void fft_engine_indicators(std::vector< std::complex<double> >& z,
+		const Index* indices, const std::size_t size,
+		const int bin1, const int bin2, const bool has_bin2);
+
+/**
+ * Split the transform Z of two packed real sequences into the first size / 2 + 1
+ * coefficients of each of their transforms.
+ * @param spectrum2 May be nullptr if only the first one is needed.
+ */
+inline void fft_engine_split(const std::vector< std::complex<double> >& Z,
+		std::complex<double>* spectrum1, std::complex<double>* spectrum2);
+
+
+/**
+ * Calculate the mutual information with bit planes (see BitPlanes.h): the joint count
+ * of (bx, by) for a shift is the popcount of the plane of bx AND the shifted plane of by.
+ * This needs binsX * binsY operations per 64 samples, so it is fast for very few bins
+ * such as binary or 4-bin data. Like the per-shift engine, few shifts are split
+ * into chunks to keep all threads busy.
+ * Parameters are the same as for shifted_mutual_information_per_shift.
+ * @throws std::invalid_argument if there are more than bitplane_engine_max_bins bins on an axis.
+ */
+template<typename T, typename Index, typename Count = int>
+void shifted_mutual_information_bitplane(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* X, const Index* Y, const std::size_t size,
+		const int shift_step,
+		T* output,
+		const BiasCorrection correction = BIAS_NONE,
+		T* raw = nullptr,
+		T* entropies = nullptr);
+
+
+//////////////////
+/// IMPLEMENTATION
+//////////////////
+
+inline const std::vector<std::string>& shift_engine_names()
+{
+	static const std::vector<std::string> names {"auto", "per_shift", "tiled", "fft", "bitplane"};
+	return names;
+}
+
+inline ShiftEngine shift_engine_from_name(const std::string& name)
+{
+	const std::vector<std::string>& names = shift_engine_names();
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		if (names[i] == name)
+			return static_cast<ShiftEngine>(i);
+	}
+	throw std::invalid_argument("Unknown engine: " + name);
+}
+
+inline double fft_engine_bytes(const int nr_shifts, const std::size_t size,
+	const int binsX, const int binsY, const std::size_t max_shift)
+{
+	const double length = double(FFT::next_power_of_two(size + max_shift));
+	const double half = length / 2 + 1;
+	const double count_bytes = needs_wide_counts(size) ? sizeof(long long) : sizeof(int);
+	return sizeof(std::complex<double>) * (binsY * half + shift_engine_threads() * (length + 2 * half))
+		+ double(nr_shifts) * binsX * binsY * count_bytes;
+}
+
+inline ShiftEngine choose_shift_engine(const int nr_shifts, const std::size_t size,
+	const int binsX, const int binsY, const std::size_t max_shift)
+{
+	// Rough costs: a histogram increment takes about as long as a butterfly of the FFT.
+	const double length = double(FFT::next_power_of_two(size + max_shift));
+	const double nr_transforms = (binsY + 1) / 2 + (binsX + 1) / 2 * (binsY + 1.);
+	const double fft_cost = 2. * nr_transforms * length * std::log2(length);
+	const double histogram_cost = double(nr_shifts) * double(size);
+	const double bitplane_cost = binsX <= bitplane_engine_max_bins && binsY <= bitplane_engine_max_bins
+		? histogram_cost * binsX * binsY / bitplane_engine_cells_per_increment
+		: histogram_cost;
+	if (fft_cost < std::min(histogram_cost, bitplane_cost)
+		&& fft_engine_bytes(nr_shifts, size, binsX, binsY, max_shift) <= fft_engine_max_bytes)
+		return ENGINE_FFT;
+	if (bitplane_cost < histogram_cost)
+		return ENGINE_BITPLANE;
+	// Tiling only pays off if the data does not fit into the cache anyway
+	// and the chunks are still large enough for the lane-private histogram kernels.
+	// Blocks of shifts are not split, so there must be enough of them for all threads.
+	const int nr_blocks = (nr_shifts - 1) / tiled_engine_block_shifts + 1;
+	if (nr_shifts > 1 && size > 4 * tiled_engine_chunk_size
+		&& nr_blocks >= shift_engine_threads()
+		&& histogram_kernel_use_lanes(binsX, binsY, tiled_engine_chunk_size))
+		return ENGINE_TILED;
+	else
+		return ENGINE_PER_SHIFT;
+}
+
+inline int shift_engine_threads()
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+inline int chunks_per_shift(const int nr_shifts, const std::size_t size, const int nr_threads)
+{
+	if (nr_shifts >= nr_threads)
+		return 1;
+	const std::size_t wanted = (nr_threads + nr_shifts - 1) / nr_shifts;
+	const std::size_t limit = std::max(size / split_shift_min_samples, std::size_t(1));
+	return int(std::min(wanted, limit));
+}
+
+inline bool needs_wide_counts(const std::size_t size)
+{
+	return size > std::size_t(std::numeric_limits<int>::max());
+}
+
+template<typename T, typename Count, typename Iterator>
+void increment_shifted(Histogram2d<T, Count>& hist, const int shift,
+	const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY)
+{
+	if (shift < 0)
+	{
+		hist.increment_cpu(beginX, std::prev(endX, -shift),
+			std::next(beginY, -shift), endY);
+	}
+	else if (shift > 0)
+	{
+		hist.increment_cpu(std::next(beginX, shift), endX,
+			beginY, std::prev(endY, shift));
+	}
+	else // Should not be necessary but better be explicit.
+	{
+		hist.increment_cpu(beginX, endX,
+			beginY, endY);
+	}
+}
+
+template<typename T, typename Count>
+void store_shift_result(Histogram2d<T, Count>& hist, const int s,
+	T* output, const BiasCorrection correction, T* raw, T* entropies)
+{
+	output[s] = hist.calculate_corrected_mutual_information(correction, raw ? raw + s : nullptr);
+	if (entropies)
+		hist.calculate_entropies(entropies + 3 * std::size_t(s));
+}
+
+template<typename T, typename Count>
+void store_shift_result(const Count* H, const int binsX, const int binsY, Count* hX, Count* hY, const int s,
+	T* output, const BiasCorrection correction, T* raw, T* entropies)
+{
+	const T mi = mutual_information_from_joint_counts<T>(H, binsX, binsY, hX, hY);
+	if (raw)
+		raw[s] = mi;
+	if (correction == BIAS_NONE && !entropies)
+	{
+		output[s] = mi;
+		return;
+	}
+	// The marginals have just been summed up by mutual_information_from_joint_counts.
+	long long count = 0;
+	for (int x = 0; x < binsX; ++x)
+	{
+		count += hX[x];
+	}
+	// The corrected value may be slightly negative for independent data.
+	output[s] = correction == BIAS_NONE ? mi
+		: T(mi - mutual_information_bias(H, hX, hY, binsX, binsY, count, correction));
+	if (entropies)
+	{
+		T* e = entropies + 3 * std::size_t(s);
+		e[0] = entropy_from_counts<T>(hX, binsX, count);
+		e[1] = entropy_from_counts<T>(hY, binsY, count);
+		e[2] = entropy_from_counts<T>(H, std::size_t(binsX) * binsY, count);
+	}
+}
+
+template<typename T, typename Index, typename Count>
+void shifted_mutual_information_per_shift(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size,
+	const int shift_step,
+	T* output,
+	const BiasCorrection correction /* BIAS_NONE */,
+	T* raw /* nullptr */,
+	T* entropies /* nullptr */)
+{
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const int chunks = chunks_per_shift(nr_shifts, size, shift_engine_threads());
+	if (chunks > 1)
+	{
+		const int nr_tasks = nr_shifts * chunks;
+		const long long n = size;
+		std::vector< std::unique_ptr<Histogram2d<T, Count>> > partial(nr_tasks);
+#pragma omp parallel for schedule(dynamic)
+		for (int t = 0; t < nr_tasks; ++t)
+		{
+			// Chunk c of the pairs X[k], Y[k - i] with k in [max(0, i), n + min(0, i)).
+			const long long i = shift_from + (long long)(t / chunks) * shift_step;
+			const long long c = t % chunks;
+			const long long begin = std::max(0LL, i);
+			const long long length = n + std::min(0LL, i) - begin;
+			const long long chunk_begin = begin + length * c / chunks;
+			const long long chunk_end = begin + length * (c + 1) / chunks;
+			partial[t].reset(new Histogram2d<T, Count>(binsX, binsY, minX, maxX, minY, maxY));
+			partial[t]->increment_cpu(X + chunk_begin, X + chunk_end,
+				Y + (chunk_begin - i), Y + (chunk_end - i));
+		}
+		// Tree reduction: in each round chunk c adds chunk c + stride.
+		for (int stride = 1; stride < chunks; stride *= 2)
+		{
+#pragma omp parallel for schedule(static)
+			for (int t = 0; t < nr_tasks; ++t)
+			{
+				const int c = t % chunks;
+				if (c % (2 * stride) == 0 && c + stride < chunks)
+					partial[t]->add(*partial[t + stride]);
+			}
+		}
+		for (int s = 0; s < nr_shifts; ++s)
+		{
+			store_shift_result(*partial[s * chunks], s, output, correction, raw, entropies);
+		}
+		return;
+	}
+#pragma omp parallel
+	{
+		// One histogram per thread which is reused for all of its shifts.
+		Histogram2d<T, Count> hist(binsX, binsY, minX, maxX, minY, maxY);
+#pragma omp for schedule(static)
+		for (int i = shift_from; i <= shift_to; i += shift_step)
+		{
+			hist.reset();
+			increment_shifted(hist, i, X, X + size, Y, Y + size);
+			store_shift_result(hist, (i - shift_from) / shift_step, output, correction, raw, entropies);
+		}
+	}
+}
+
+template<typename T, typename Index, typename Count>
+void shifted_mutual_information_tiled(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size,
+	const int shift_step,
+	T* output,
+	const BiasCorrection correction /* BIAS_NONE */,
+	T* raw /* nullptr */,
+	T* entropies /* nullptr */)
+{
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const int nr_blocks = (nr_shifts - 1) / tiled_engine_block_shifts + 1;
+	const long long n = size;
+#pragma omp parallel
+	{
+		// One histogram per shift of a block, reused for all blocks of this thread.
+		std::vector< std::unique_ptr<Histogram2d<T, Count>> > hists;
+		for (int s = 0; s < tiled_engine_block_shifts; ++s)
+		{
+			hists.emplace_back(new Histogram2d<T, Count>(binsX, binsY, minX, maxX, minY, maxY));
+		}
+#pragma omp for schedule(dynamic)
+		for (int block = 0; block < nr_blocks; ++block)
+		{
+			const int first = block * tiled_engine_block_shifts;
+			const int last = std::min(first + tiled_engine_block_shifts, nr_shifts);
+			for (int s = first; s < last; ++s)
+			{
+				hists[s - first]->reset();
+			}
+			for (long long chunk = 0; chunk < n; chunk += tiled_engine_chunk_size)
+			{
+				const long long chunk_end = std::min(chunk + (long long)tiled_engine_chunk_size, n);
+				for (int s = first; s < last; ++s)
+				{
+					// Shift i pairs X[k] with Y[k - i] for k in [max(0, i), n + min(0, i)).
+					const long long i = shift_from + (long long)s * shift_step;
+					const long long begin = std::max(chunk, std::max(0LL, i));
+					const long long end = std::min(chunk_end, n + std::min(0LL, i));
+					if (begin < end)
+					{
+						hists[s - first]->increment_cpu(X + begin, X + end,
+							Y + (begin - i), Y + (end - i));
+					}
+				}
+			}
+			for (int s = first; s < last; ++s)
+			{
+				store_shift_result(*hists[s - first], s, output, correction, raw, entropies);
+			}
+		}
+	}
+}
+
+template<typename Index>
+void fft_engine_indicators(std::vector< std::complex<double> >& z,
+	const Index* indices, const std::size_t size,
+	const int bin1, const int bin2, const bool has_bin2)
+{
+	for (std::size_t k = 0; k < size; ++k)
+	{
+		const long long index = indices[k];
+		z[k] = std::complex<double>(index == bin1, has_bin2 && index == bin2);
+	}
+	std::fill(z.begin() + size, z.end(), std::complex<double>(0., 0.));
+}
+
+inline void fft_engine_split(const std::vector< std::complex<double> >& Z,
+	std::complex<double>* spectrum1, std::complex<double>* spectrum2)
+{
+	const std::size_t n = Z.size();
+	for (std::size_t k = 0; k <= n / 2; ++k)
+	{
+		// A[k] = (Z[k] + conj(Z[n - k])) / 2, B[k] = (Z[k] - conj(Z[n - k])) / 2i
+		const std::complex<double> z = Z[k];
+		const std::complex<double> r = Z[(n - k) & (n - 1)];
+		spectrum1[k] = std::complex<double>(0.5 * (z.real() + r.real()), 0.5 * (z.imag() - r.imag()));
+		if (spectrum2)
+			spectrum2[k] = std::complex<double>(0.5 * (z.imag() + r.imag()), 0.5 * (r.real() - z.real()));
+	}
+}
+
+template<typename T, typename Index, typename Count>
+void shifted_mutual_information_fft(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size,
+	const int shift_step,
+	T* output,
+	const BiasCorrection correction /* BIAS_NONE */,
+	T* raw /* nullptr */,
+	T* entropies /* nullptr */)
+{
+	typedef std::complex<double> complex;
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const std::size_t max_shift = std::max(std::abs(shift_from), std::abs(shift_to));
+	// Padding with at least max_shift zeros keeps the circular correlation from wrapping around.
+	const FFT fft(FFT::next_power_of_two(size + max_shift));
+	const std::size_t n = fft.size();
+	const std::size_t half = n / 2 + 1;
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	// Correlations with bins that never occur are zero and need no transforms.
+	std::vector<char> usedX(binsX, 0);
+	std::vector<char> usedY(binsY, 0);
+	for (std::size_t k = 0; k < size; ++k)
+	{
+		if (std::size_t(X[k]) < std::size_t(binsX))
+			usedX[X[k]] = 1;
+		if (std::size_t(Y[k]) < std::size_t(binsY))
+			usedY[Y[k]] = 1;
+	}
+	std::vector<complex> spectraY(binsY * half);
+	std::vector<Count> counts(std::size_t(nr_shifts) * cells, 0);
+	const int nr_pairsX = (binsX + 1) / 2;
+	const int nr_pairsY = (binsY + 1) / 2;
+	const long long nr_tasks = (long long)nr_pairsX * binsY;
+#pragma omp parallel
+	{
+		std::vector<complex> z(n);
+#pragma omp for schedule(dynamic)
+		for (int p = 0; p < nr_pairsY; ++p)
+		{
+			const int b1 = 2 * p;
+			const bool has_b2 = b1 + 1 < binsY;
+			if (!usedY[b1] && !(has_b2 && usedY[b1 + 1]))
+				continue;
+			fft_engine_indicators(z, Y, size, b1, b1 + 1, has_b2);
+			fft.transform(z.data());
+			fft_engine_split(z, &spectraY[b1 * half], has_b2 ? &spectraY[(b1 + 1) * half] : nullptr);
+		}
+		// Each task correlates a pair of X bins with one Y bin. Consecutive tasks of
+		// a thread share the X pair so its transform is only calculated once.
+		std::vector<complex> spectrumX1(half);
+		std::vector<complex> spectrumX2(half);
+		int cached = -1;
+#pragma omp for schedule(static)
+		for (long long t = 0; t < nr_tasks; ++t)
+		{
+			const int p = int(t / binsY);
+			const int by = int(t % binsY);
+			const int bx1 = 2 * p;
+			const bool has_bx2 = bx1 + 1 < binsX;
+			if (!usedY[by] || !(usedX[bx1] || (has_bx2 && usedX[bx1 + 1])))
+				continue;
+			if (p != cached)
+			{
+				fft_engine_indicators(z, X, size, bx1, bx1 + 1, has_bx2);
+				fft.transform(z.data());
+				fft_engine_split(z, spectrumX1.data(), spectrumX2.data());
+				cached = p;
+			}
+			// Both cross spectra S = A * conj(B) belong to real sequences (S[n - k] = conj(S[k]))
+			// so they can again be packed as S1 + i * S2 for a single inverse transform.
+			const complex* B = &spectraY[by * half];
+			for (std::size_t k = 0; k < half; ++k)
+			{
+				const double br = B[k].real();
+				const double bi = -B[k].imag();
+				const double s1r = spectrumX1[k].real() * br - spectrumX1[k].imag() * bi;
+				const double s1i = spectrumX1[k].real() * bi + spectrumX1[k].imag() * br;
+				const double s2r = spectrumX2[k].real() * br - spectrumX2[k].imag() * bi;
+				const double s2i = spectrumX2[k].real() * bi + spectrumX2[k].imag() * br;
+				z[k] = complex(s1r - s2i, s1i + s2r);
+				if (k > 0 && k < n - k)
+					z[n - k] = complex(s1r + s2i, s2r - s1i);
+			}
+			fft.transform(z.data(), true);
+			// Entry j of the circular correlation is the count of shift j (or j - n if negative).
+			for (int s = 0; s < nr_shifts; ++s)
+			{
+				const long long i = shift_from + (long long)s * shift_step;
+				const complex c = z[i >= 0 ? i : n + i];
+				Count* H = &counts[s * cells];
+				H[bx1 * binsY + by] = Count(std::llround(c.real() / n));
+				if (has_bx2)
+					H[(bx1 + 1) * binsY + by] = Count(std::llround(c.imag() / n));
+			}
+		}
+		std::vector<Count> hX(binsX);
+		std::vector<Count> hY(binsY);
+#pragma omp for schedule(static)
+		for (int s = 0; s < nr_shifts; ++s)
+		{
+			store_shift_result(&counts[s * cells], binsX, binsY, hX.data(), hY.data(), s,
+				output, correction, raw, entropies);
+		}
+	}
+}
+
+template<typename T, typename Index, typename Count>
+void shifted_mutual_information_bitplane(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size,
+	const int shift_step,
+	T* output,
+	const BiasCorrection correction /* BIAS_NONE */,
+	T* raw /* nullptr */,
+	T* entropies /* nullptr */)
+{
+	if (binsX > bitplane_engine_max_bins || binsY > bitplane_engine_max_bins)
+		throw std::invalid_argument("The bitplane engine supports at most 16 bins per axis.");
+	const BitPlanes planesX(binsX, X, size);
+	const BitPlanes planesY(binsY, Y, size);
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const int chunks = chunks_per_shift(nr_shifts, size, shift_engine_threads());
+	const int nr_tasks = nr_shifts * chunks;
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	const std::size_t block = bitplane_engine_block_words;
+	const long long n = size;
+	// Counts of each chunk if shifts are split; otherwise every thread reuses its own.
+	std::vector<Count> partial(chunks > 1 ? nr_tasks * cells : 0, 0);
+#pragma omp parallel
+	{
+		std::vector<std::uint64_t, AlignedAllocator<std::uint64_t>> shiftedY(binsY * block);
+		std::vector<Count> counts(chunks > 1 ? 0 : cells);
+		std::vector<Count> hX(binsX);
+		std::vector<Count> hY(binsY);
+#pragma omp for schedule(static)
+		for (int t = 0; t < nr_tasks; ++t)
+		{
+			// Shift i pairs X[k] with Y[k - i]; only words of X overlapping
+			// [max(0, i), n + min(0, i)) can hold pairs.
+			const long long i = shift_from + (long long)(t / chunks) * shift_step;
+			const std::size_t c = t % chunks;
+			const std::size_t begin_word = std::max(0LL, i) / 64;
+			const std::size_t nr_words = (n + std::min(0LL, i) + 63) / 64 - begin_word;
+			const std::size_t first_word = begin_word + nr_words * c / chunks;
+			const std::size_t end_word = begin_word + nr_words * (c + 1) / chunks;
+			Count* H = chunks > 1 ? &partial[t * cells] : counts.data();
+			std::fill(H, H + cells, 0);
+			for (std::size_t w = first_word; w < end_word; w += block)
+			{
+				const std::size_t len = std::min(block, end_word - w);
+				for (int by = 0; by < binsY; ++by)
+				{
+					planesY.shifted(by, i, w, len, &shiftedY[by * block]);
+				}
+				for (int bx = 0; bx < binsX; ++bx)
+				{
+					const std::uint64_t* px = planesX[bx] + w;
+					for (int by = 0; by < binsY; ++by)
+					{
+						H[bx * binsY + by] += Count(and_popcount(px, &shiftedY[by * block], len));
+					}
+				}
+			}
+			if (chunks == 1)
+				store_shift_result(H, binsX, binsY, hX.data(), hY.data(), t,
+					output, correction, raw, entropies);
+		}
+		if (chunks > 1)
+		{
+#pragma omp for schedule(static)
+			for (int s = 0; s < nr_shifts; ++s)
+			{
+				Count* H = &partial[s * chunks * cells];
+				for (int c = 1; c < chunks; ++c)
+				{
+					const Count* h = H + c * cells;
+					for (std::size_t j = 0; j < cells; ++j)
+					{
+						H[j] += h[j];
+					}
+				}
+				store_shift_result(H, binsX, binsY, hX.data(), hY.data(), s,
+					output, correction, raw, entropies);
+			}
+		}
+	}
+}
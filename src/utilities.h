@@ -24,23 +24,54 @@
 #include <stdexcept>
 #include <iterator>
 #include <climits>
-#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "Histogram2d.h"
+#include "BootstrapArena.h"
+#include "bootstrap_rng.h"
+#include "bootstrap_mode.h"
+#include "shift_engines.h"
+#include "numa_placement.h"
+
+/**
+ * Value marking data outside of the [min,max] range in index arrays of type Index.
+ * Because it is the largest representable value it is never smaller than the
+ * number of bins and therefore ignored by all histograms.
+ */
+template<typename Index>
+constexpr Index index_sentinel()
+{
+	return std::numeric_limits<Index>::max();
+}
+
+/**
+ * Size in bytes of the narrowest index type able to hold indices in [0, bins)
+ * as well as the sentinel value: 1 (uint8_t), 2 (uint16_t) or 4 (int).
+ */
+inline int index_width(const int bins);
 
 /**
  * Calculates the histogram indices of a certain data container.
+ * @tparam Index Type of the resulting indices; bins has to be smaller than
+ *         index_sentinel<Index>(). Use uint8_t or uint16_t to save memory. (default: int)
  * @param bins Number of bins for the imaginary histogram.
  * @param min Minimum value in data container.
  * @param max Maximum value in data container.
  * @param begin Iterator to the beginning of the data.
  * @param end Iterator to the end of the data.
  * @return A vector with the same size as the data holding the index positions.
- * 	       If there is a value outside the [min,max] range UINT_MAX is inserted
- * 	       at this position.
+ * 	       If there is a value outside the [min,max] range index_sentinel<Index>()
+ * 	       is inserted at this position.
  */
-template<typename T, typename Iterator>
-std::vector<int> calculate_indices_1d(
+template<typename Index = int, typename T, typename Iterator>
+std::vector<Index> calculate_indices_1d(
 		const int bins,
 		const T min, const T max,
 		const Iterator begin, const Iterator end);
@@ -48,12 +79,15 @@ std::vector<int> calculate_indices_1d(
 /**
  * Small struct for simply holding two index values.
  */
-struct index_pair
+template<typename Index>
+struct basic_index_pair
 {
-	int first;
-	int second;
+	Index first;
+	Index second;
 };
 
+typedef basic_index_pair<int> index_pair;
+
 /**
  * Calculate indices of a 2d histogram for a certain data container.
  * @param binsX Number of bins on imaginary histogram's x-axis.
@@ -67,12 +101,12 @@ struct index_pair
  * @param beginY Iterator to the beginning of the second data container.
  * @param endY Iterator to the end of the second data container.
  * 			   Both containers must have the same size.
- * @return Vector of index_pair structs. The vector has the same size as the data.
- *         If there is a value outside the [min,max] range index_pair {UINT_MAX, UINT_MAX}
- *         is inserted at this position.
+ * @return Vector of index pairs. The vector has the same size as the data.
+ *         If there is a value outside the [min,max] range both indices are set
+ *         to index_sentinel<Index>() at this position.
  */
-template<typename T, typename Iterator>
-std::vector<index_pair> calculate_indices_2d(
+template<typename Index = int, typename T, typename Iterator>
+std::vector< basic_index_pair<Index> > calculate_indices_2d(
 		const int binsX, const int binsY,
 		const T minX, const T maxX,
 		const T minY, const T maxY,
@@ -104,6 +138,15 @@ std::vector<index_pair> calculate_indices_2d(
  * @param endY Iterator to the end of the second data container.
  * 			   Both containers must have the same size.
  * @param shift_step (Optional) Specifies the steps between shifts. Default = 1.
+ * @param engine (Optional) Strategy for calculating the histograms, see shift_engines.h.
+ * 		  All engines give the same results. Default = ENGINE_AUTO.
+ * @param numa (Optional) Placement of the histogram indices on NUMA systems,
+ * 		  see numa_placement.h. Default = NUMA_NONE.
+ * @param correction (Optional) Subtract an estimate of the bias from the mutual information,
+ * 		  see bias_correction.h. This costs next to nothing. Default = BIAS_NONE.
+ * @param raw (Optional) Receives the uncorrected values side by side with the corrected ones.
+ * @param entropies (Optional) Receives H(X), H(Y) and H(X,Y) of every shift one after the other,
+ * 		  see information_measures.h for the measures derived from them.
  * @return Vector with size (shift_to - shift_from) holding the mutual information for each shift.
  * 		   Might be smaller if shift_step is specified.
  */
@@ -114,7 +157,82 @@ std::vector<T> shifted_mutual_information(
 		const T minX, const T maxX, const T minY, const T maxY,
 		const Iterator beginX, const Iterator endX,
 		const Iterator beginY, const Iterator endY,
-		const int shift_step = 1);
+		const int shift_step = 1,
+		const ShiftEngine engine = ENGINE_AUTO,
+		const NumaPolicy numa = NUMA_NONE,
+		const BiasCorrection correction = BIAS_NONE,
+		std::vector<T>* raw = nullptr,
+		std::vector<T>* entropies = nullptr);
+
+/**
+ * Common part of both shifted_mutual_information overloads which works on
+ * already calculated histogram indices in range [0, nr_bins).
+ * It runs the requested engine from shift_engines.h. Arguments are not checked here.
+ * @param output A pointer to a vector of size (shift_to - shift_from) / shift_step + 1
+ * Histograms count in long long if there are more than INT_MAX samples, otherwise in int.
+ * @param engine Which engine to use for calculating the histograms. (default: ENGINE_AUTO)
+ * @param correction Bias correction, see bias_correction.h. (default: BIAS_NONE)
+ * @param raw If not nullptr, receives the uncorrected values. (default: nullptr)
+ * @param entropies If not nullptr, receives H(X), H(Y) and H(X,Y) of every shift. (default: nullptr)
+ */
+template<typename T, typename Index>
+void shifted_mutual_information_from_indices(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* beginX, const Index* endX,
+		const Index* beginY, const Index* endY,
+		const int shift_step,
+		T* output,
+		const ShiftEngine engine = ENGINE_AUTO,
+		const BiasCorrection correction = BIAS_NONE,
+		T* raw = nullptr,
+		T* entropies = nullptr);
+
+/**
+ * Helper for shifted_mutual_information_from_indices running the engine
+ * (not ENGINE_AUTO) with histograms of type Histogram2d<T, Count>.
+ */
+template<typename Count, typename T, typename Index>
+void shifted_mutual_information_with_counts(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* X, const Index* Y, const std::size_t size,
+		const int shift_step,
+		T* output,
+		const ShiftEngine engine,
+		const BiasCorrection correction,
+		T* raw,
+		T* entropies);
+
+/**
+ * Like shifted_mutual_information_from_indices but first places the index arrays
+ * according to a NUMA policy:
+ * NUMA_INTERLEAVE copies them to memory interleaved over all nodes and pins the
+ * threads round-robin to the nodes. NUMA_REPLICATE runs one team of threads per node,
+ * each pinned to its node with a local copy of the indices and a contiguous part of the shifts.
+ * With NUMA_NONE or a single node the indices are used as they are.
+ */
+template<typename T, typename Index>
+void shifted_mutual_information_numa(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* beginX, const Index* endX,
+		const Index* beginY, const Index* endY,
+		const int shift_step,
+		T* output,
+		const ShiftEngine engine,
+		const NumaPolicy numa,
+		const BiasCorrection correction,
+		T* raw,
+		T* entropies);
+
+/**
+ * Number of repetitions of bootstrapped_mi whose histograms are summed up at once (see combine_histograms).
+ */
+constexpr int bootstrap_repetition_block {16};
 
 /**
  * Calculates the mutual information of the two given data vectors X and Y
@@ -122,19 +240,68 @@ std::vector<T> shifted_mutual_information(
  * histograms by sampling the data and then again sampling these histograms
  * and adding them together.
  * Helper function for shifted_mutual_information_with_bootstrap.
+ * @param rgen Any generator accepted by draw_bounded (see bootstrap_rng.h).
  */
-template<typename T, typename Iterator>
+template<typename T, typename Iterator, typename Rng>
 std::vector<T> bootstrapped_mi(const Iterator beginX, const Iterator endX,
 				  const Iterator beginY, const Iterator endY,
 				  const int binsX, const int binsY,
 				  const T minX, const T maxX, const T minY, const T maxY,
-				  int nr_samples, int nr_repetitions, std::mt19937& rgen);
+				  int nr_samples, int nr_repetitions, Rng& rgen);
+
+/**
+ * bootstrapped_mi with histograms of Count counters, all of them taken from arena.
+ */
+template<typename Count, typename T, typename Iterator, typename Rng>
+std::vector<T> bootstrapped_mi_with_counts(const Iterator beginX, const Iterator endX,
+				  const Iterator beginY, const Iterator endY,
+				  const int binsX, const int binsY,
+				  const T minX, const T maxX, const T minY, const T maxY,
+				  int nr_samples, int nr_repetitions, Rng& rgen,
+				  BootstrapArena<Count>& arena);
+
+/**
+ * Bootstrap the joint histogram of X and Y itself: every repetition draws a histogram
+ * of the same number of values from the multinomial distribution of the observed
+ * histogram (see draw_multinomial). After filling the observed histogram once, a
+ * repetition costs O(binsX * binsY) instead of O(size) random draws.
+ */
+template<typename Count, typename T, typename Iterator, typename Rng>
+std::vector<T> multinomial_bootstrapped_mi_with_counts(const Iterator beginX, const Iterator endX,
+				  const Iterator beginY, const Iterator endY,
+				  const int binsX, const int binsY,
+				  int nr_repetitions, Rng& rgen,
+				  BootstrapArena<Count>& arena);
+
+/**
+ * Bootstrap every shift of the histogram indices X and Y with one BootstrapArena per thread.
+ * Arguments are not checked here.
+ * @param output A pointer to a vector of size ((shift_to - shift_from) / shift_step + 1) * nr_repetitions
+ * @param seed Seed of all shifts; the generator of a shift is keyed by the seed and the shift.
+ */
+template<typename Count, typename T, typename Index>
+void bootstrap_shifts(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Index* X, const Index* Y, const std::size_t size,
+		int nr_samples, int nr_repetitions,
+		const int shift_step,
+		T* output,
+		const BootstrapRng rng,
+		const uint64_t seed,
+		const BootstrapMode mode);
 
 /**
  * Similar to shifted_mutual_information but additionally uses bootstrapping
  * this increasing its runtime. There are two additional parameters:
  * @param nr_samples How many temporary histograms to generate by sampling the data.
  * @param nr_repetitions How many times to repeat this process to minimize noise.
+ * @param rng (Optional) Generator for drawing the samples. Default = RNG_XOSHIRO256PP.
+ * @param seed (Optional) With the same seed every shift gets the same values, regardless of
+	the range of shifts and the number of threads. Default = clock_seed().
+ * @param mode (Optional) How the replicates are drawn; nr_samples is not used by
+	BOOTSTRAP_MULTINOMIAL. Default = BOOTSTRAP_HISTOGRAMS.
  * @return A vector of size `(shift_to - shift_from) / shift_step + 1`
 	holding vectors of size `nr_repetitions` with the mutual information.
  */
@@ -146,47 +313,114 @@ std::vector< std::vector<T> > shifted_mutual_information_with_bootstrap(
 		const Iterator beginX, const Iterator endX,
 		const Iterator beginY, const Iterator endY,
 		int nr_samples, int nr_repetitions,
-		const int shift_step = 1);
+		const int shift_step = 1,
+		const BootstrapRng rng = RNG_XOSHIRO256PP,
+		const uint64_t seed = clock_seed(),
+		const BootstrapMode mode = BOOTSTRAP_HISTOGRAMS);
 
 /**
  * This is for the matlab mex interface:
  * Instead of returning a vector the result is written to a pointer location.
  * The values specified by beginX, endX, beginY, endY are the histogram indices in range [0, nr_bins).
+ * Indices may be of any integral type, preferably the narrowest one fitting the bins
+ * (e.g. uint8_t); all values greater or equal nr_bins are ignored.
  * @param output A pointer to to a vector of size (shift_to - shift_from) / shift_step + 1
+ * @param engine (Optional) Strategy for calculating the histograms. Default = ENGINE_AUTO.
+ * @param correction (Optional) Bias correction, see bias_correction.h. Default = BIAS_NONE.
+ * @param raw (Optional) Receives the uncorrected values; same size as output.
+ * @param entropies (Optional) Receives H(X), H(Y) and H(X,Y) of every shift; three times the size of output.
  */
-template<typename T>
+template<typename T, typename Index>
 void shifted_mutual_information(
 	    const int shift_from, const int shift_to,
 		const int binsX, const int binsY,
 		const T minX, const T maxX, const T minY, const T maxY,
-		const int* beginX, const int* endX,
-		const int* beginY, const int* endY,
+		const Index* beginX, const Index* endX,
+		const Index* beginY, const Index* endY,
 		const int shift_step,
-		T* output);
+		T* output,
+		const ShiftEngine engine = ENGINE_AUTO,
+		const BiasCorrection correction = BIAS_NONE,
+		T* raw = nullptr,
+		T* entropies = nullptr);
 
 /**
  * This is for the matlab mex interface:
  * Instead of returning a vector the result is written to a pointer location.
  * The values specified by beginX, endX, beginY, endY are the histogram indices in range [0, nr_bins).
+ * Like above the indices may be of any (preferably narrow) integral type.
  * @param output A pointer to to a vector of size ((shift_to - shift_from) / shift_step + 1) * nr_repetitions
+ * @param rng (Optional) Generator for drawing the samples. Default = RNG_XOSHIRO256PP.
+ * @param seed (Optional) Seed of all shifts. Default = clock_seed().
+ * @param mode (Optional) How the replicates are drawn. Default = BOOTSTRAP_HISTOGRAMS.
  */
-template<typename T>
+template<typename T, typename Index>
 void shifted_mutual_information_with_bootstrap(
 		const int shift_from, const int shift_to,
 		const int binsX, const int binsY,
 		const T minX, const T maxX, const T minY, const T maxY,
-		const int* beginX, const int* endX,
-		const int* beginY, const int* endY,
+		const Index* beginX, const Index* endX,
+		const Index* beginY, const Index* endY,
+		int nr_samples, int nr_repetitions,
+		const int shift_step,
+		T* output,
+		const BootstrapRng rng = RNG_XOSHIRO256PP,
+		const uint64_t seed = clock_seed(),
+		const BootstrapMode mode = BOOTSTRAP_HISTOGRAMS);
+
+/**
+ * Bin both data containers into indices of type Index and run
+ * shifted_mutual_information_from_indices on them.
+ * Helper for dispatching shifted_mutual_information to the narrowest index type.
+ */
+template<typename Index, typename T, typename Iterator>
+void shifted_mutual_information_binned(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Iterator beginX, const Iterator endX,
+		const Iterator beginY, const Iterator endY,
+		const int shift_step,
+		T* output,
+		const ShiftEngine engine,
+		const NumaPolicy numa,
+		const BiasCorrection correction,
+		T* raw,
+		T* entropies);
+
+/**
+ * Bin both data containers into indices of type Index and do the bootstrapping on them.
+ * Helper for dispatching shifted_mutual_information_with_bootstrap to the narrowest index type.
+ */
+template<typename Index, typename T, typename Iterator>
+std::vector< std::vector<T> > shifted_mutual_information_with_bootstrap_binned(
+		const int shift_from, const int shift_to,
+		const int binsX, const int binsY,
+		const T minX, const T maxX, const T minY, const T maxY,
+		const Iterator beginX, const Iterator endX,
+		const Iterator beginY, const Iterator endY,
 		int nr_samples, int nr_repetitions,
 		const int shift_step,
-		T* output);
+		const BootstrapRng rng,
+		const uint64_t seed,
+		const BootstrapMode mode);
 
 //////////////////
 /// IMPLEMENTATION
 //////////////////
 
-template<typename T, typename Iterator>
-std::vector<int> calculate_indices_1d(
+inline int index_width(const int bins)
+{
+	if (bins < index_sentinel<uint8_t>())
+		return 1;
+	else if (bins < index_sentinel<uint16_t>())
+		return 2;
+	else
+		return 4;
+}
+
+template<typename Index, typename T, typename Iterator>
+std::vector<Index> calculate_indices_1d(
 	const int bins,
 	const T min, const T max,
 	const Iterator begin, const Iterator end)
@@ -195,11 +429,13 @@ std::vector<int> calculate_indices_1d(
 		throw std::logic_error("min has to be smaller than max.");
 	if (bins < 1)
 		throw std::invalid_argument("There must be at least one bin.");
-	int size = std::distance(begin, end);
-	std::vector<int> result(size);
+	if ((long long)bins >= (long long)index_sentinel<Index>())
+		throw std::invalid_argument("Index type is too narrow for this number of bins.");
+	const long long size = std::distance(begin, end);
+	std::vector<Index> result(size);
 	// Most code token from Histogram1d class.
 #pragma omp parallel for
-	for (int i = 0; i < size; ++i)
+	for (long long i = 0; i < size; ++i)
 	{
 		auto value = begin[i];
 		if (value >= min && value < max)
@@ -207,22 +443,22 @@ std::vector<int> calculate_indices_1d(
 			T normalized = (value - min) / (max - min);
 #pragma warning(suppress: 4244)
 			int index = normalized * bins;  // Implicit conversion to integer.
-			result[i] = index;
+			result[i] = Index(index);
 		}
 		else if (value == max)
 		{
-			result[i] = bins - 1;
+			result[i] = Index(bins - 1);
 		}
 		else
 		{
-			result[i] = INT_MAX;
+			result[i] = index_sentinel<Index>();
 		}
 	}
 	return result;
 }
 
-template<typename T, typename Iterator>
-std::vector<index_pair> calculate_indices_2d(
+template<typename Index, typename T, typename Iterator>
+std::vector< basic_index_pair<Index> > calculate_indices_2d(
 	const int binsX, const int binsY,
 	const T minX, const T maxX,
 	const T minY, const T maxY,
@@ -237,14 +473,16 @@ std::vector<index_pair> calculate_indices_2d(
 		throw std::invalid_argument("There must be at least one binX.");
 	if (binsY < 1)
 		throw std::invalid_argument("There must be at least one binY.");
-	int sizeX = std::distance(beginX, endX);
-	int sizeY = std::distance(beginY, endY);
+	if ((long long)std::max(binsX, binsY) >= (long long)index_sentinel<Index>())
+		throw std::invalid_argument("Index type is too narrow for this number of bins.");
+	const long long sizeX = std::distance(beginX, endX);
+	const long long sizeY = std::distance(beginY, endY);
 	if (sizeX != sizeY)
 		throw std::logic_error("Containers referenced by iterators must have the same size.");
-	std::vector<index_pair> result(sizeX);
+	std::vector< basic_index_pair<Index> > result(sizeX);
 	// Most code token from Histogram2d class.
 #pragma omp parallel for
-	for (int i = 0; i < sizeX; ++i)
+	for (long long i = 0; i < sizeX; ++i)
 	{
 		auto x = beginX[i];
 		auto y = beginY[i];
@@ -265,11 +503,11 @@ std::vector<index_pair> calculate_indices_2d(
 			else
 #pragma warning(suppress: 4244)
 				indexY = (y - minY) / (maxY - minY) * binsY;
-			result[i] = index_pair{ indexX, indexY }; // I hope this is allowed.
+			result[i] = basic_index_pair<Index>{ Index(indexX), Index(indexY) };
 		}
 		else
 		{
-			result[i] = index_pair{ INT_MAX, INT_MAX };
+			result[i] = basic_index_pair<Index>{ index_sentinel<Index>(), index_sentinel<Index>() };
 		}
 	}
 	return result;
@@ -309,89 +547,404 @@ std::vector<T> shifted_mutual_information(
 	const T minX, const T maxX, const T minY, const T maxY,
 	const Iterator beginX, const Iterator endX,
 	const Iterator beginY, const Iterator endY,
-	const int shift_step /* 1 */)
+	const int shift_step /* 1 */,
+	const ShiftEngine engine /* ENGINE_AUTO */,
+	const NumaPolicy numa /* NUMA_NONE */,
+	const BiasCorrection correction /* BIAS_NONE */,
+	std::vector<T>* raw /* nullptr */,
+	std::vector<T>* entropies /* nullptr */)
 {
 	size_t sizeX = std::distance(beginX, endX);
 	size_t sizeY = std::distance(beginY, endY);
 	check_shifted_mutual_information(sizeX, sizeY, shift_from, shift_to,
 		binsX, binsY, minX, maxX, minY, maxY, shift_step);
-	std::vector<int> indicesX = calculate_indices_1d(binsX, minX, maxX, beginX, endX);
-	std::vector<int> indicesY = calculate_indices_1d(binsY, minY, maxY, beginY, endY);
-	auto indX_begin = indicesX.begin();
-	auto indX_end = indicesX.end();
-	auto indY_begin = indicesY.begin();
-	auto indY_end = indicesY.end();
 	std::vector<T> result((shift_to - shift_from) / shift_step + 1);
-#pragma omp parallel for
-	for (int i = shift_from; i <= shift_to; i += shift_step)
+	if (raw)
+		raw->resize(result.size());
+	T* raw_output = raw ? raw->data() : nullptr;
+	if (entropies)
+		entropies->resize(3 * result.size());
+	T* entropies_output = entropies ? entropies->data() : nullptr;
+	switch (index_width(std::max(binsX, binsY)))
 	{
-		Histogram2d<T> hist(binsX, binsY, minX, maxX, minY, maxY);
-		if (i < 0)
-		{
-			hist.increment_cpu(indX_begin, std::prev(indX_end, -i),
-				std::next(indY_begin, -i), indY_end);
-		}
-		else if (i > 0)
+	case 1:
+		shifted_mutual_information_binned<uint8_t>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			beginX, endX, beginY, endY, shift_step, result.data(), engine, numa, correction, raw_output,
+			entropies_output);
+		break;
+	case 2:
+		shifted_mutual_information_binned<uint16_t>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			beginX, endX, beginY, endY, shift_step, result.data(), engine, numa, correction, raw_output,
+			entropies_output);
+		break;
+	default:
+		shifted_mutual_information_binned<int>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			beginX, endX, beginY, endY, shift_step, result.data(), engine, numa, correction, raw_output,
+			entropies_output);
+	}
+	return result;
+}
+
+template<typename Index, typename T, typename Iterator>
+void shifted_mutual_information_binned(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	const int shift_step,
+	T* output,
+	const ShiftEngine engine,
+	const NumaPolicy numa,
+	const BiasCorrection correction,
+	T* raw,
+	T* entropies)
+{
+	std::vector<Index> indicesX = calculate_indices_1d<Index>(binsX, minX, maxX, beginX, endX);
+	std::vector<Index> indicesY = calculate_indices_1d<Index>(binsY, minY, maxY, beginY, endY);
+	shifted_mutual_information_numa(shift_from, shift_to,
+		binsX, binsY, minX, maxX, minY, maxY,
+		indicesX.data(), indicesX.data() + indicesX.size(),
+		indicesY.data(), indicesY.data() + indicesY.size(),
+		shift_step, output, engine, numa, correction, raw, entropies);
+}
+
+template<typename T, typename Index>
+void shifted_mutual_information_from_indices(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* beginX, const Index* endX,
+	const Index* beginY, const Index* endY,
+	const int shift_step,
+	T* output,
+	const ShiftEngine engine /* ENGINE_AUTO */,
+	const BiasCorrection correction /* BIAS_NONE */,
+	T* raw /* nullptr */,
+	T* entropies /* nullptr */)
+{
+	const std::size_t size = std::distance(beginX, endX);
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const std::size_t max_shift = std::max(std::abs(shift_from), std::abs(shift_to));
+	const ShiftEngine chosen = engine == ENGINE_AUTO
+		? choose_shift_engine(nr_shifts, size, binsX, binsY, max_shift) : engine;
+	if (needs_wide_counts(size))
+		shifted_mutual_information_with_counts<long long>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY, beginX, beginY, size, shift_step, output, chosen,
+			correction, raw, entropies);
+	else
+		shifted_mutual_information_with_counts<int>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY, beginX, beginY, size, shift_step, output, chosen,
+			correction, raw, entropies);
+}
+
+template<typename Count, typename T, typename Index>
+void shifted_mutual_information_with_counts(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size,
+	const int shift_step,
+	T* output,
+	const ShiftEngine engine,
+	const BiasCorrection correction,
+	T* raw,
+	T* entropies)
+{
+	switch (engine)
+	{
+	case ENGINE_TILED:
+		shifted_mutual_information_tiled<T, Index, Count>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			X, Y, size, shift_step, output, correction, raw, entropies);
+		break;
+	case ENGINE_FFT:
+		shifted_mutual_information_fft<T, Index, Count>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			X, Y, size, shift_step, output, correction, raw, entropies);
+		break;
+	case ENGINE_BITPLANE:
+		shifted_mutual_information_bitplane<T, Index, Count>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			X, Y, size, shift_step, output, correction, raw, entropies);
+		break;
+	default:
+		shifted_mutual_information_per_shift<T, Index, Count>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			X, Y, size, shift_step, output, correction, raw, entropies);
+	}
+}
+
+template<typename T, typename Index>
+void shifted_mutual_information_numa(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* beginX, const Index* endX,
+	const Index* beginY, const Index* endY,
+	const int shift_step,
+	T* output,
+	const ShiftEngine engine,
+	const NumaPolicy numa,
+	const BiasCorrection correction,
+	T* raw,
+	T* entropies)
+{
+	const int nodes = numa_node_count();
+	const std::size_t size = std::distance(beginX, endX);
+	if (numa == NUMA_NONE || nodes < 2)
+	{
+		shifted_mutual_information_from_indices(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			beginX, endX, beginY, endY, shift_step, output, engine, correction, raw, entropies);
+	}
+	else if (numa == NUMA_INTERLEAVE)
+	{
+		const NumaArray<Index> X(beginX, size, numa_interleaved);
+		const NumaArray<Index> Y(beginY, size, numa_interleaved);
+		const NumaTeamUnpin unpin;
+#pragma omp parallel
 		{
-			hist.increment_cpu(std::next(indX_begin, i), indX_end,
-				indY_begin, std::prev(indY_end, i));
+#ifdef _OPENMP
+			numa_pin_thread(omp_get_thread_num() % nodes);
+#endif
 		}
-		else // Should not be necessary but better be explicit.
+		shifted_mutual_information_from_indices(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			X.data(), X.data() + size, Y.data(), Y.data() + size,
+			shift_step, output, engine, correction, raw, entropies);
+	}
+	else
+	{
+		const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+		std::exception_ptr error;
+#ifdef _OPENMP
+		const int threads_per_node = std::max(shift_engine_threads() / nodes, 1);
+		const int max_levels = omp_get_max_active_levels();
+		omp_set_max_active_levels(2);
+#endif
+#pragma omp parallel for num_threads(nodes) schedule(static, 1)
+		for (int node = 0; node < nodes; ++node)
 		{
-			hist.increment_cpu(indX_begin, indX_end,
-				indY_begin, indY_end);
+			const int first = (long long)nr_shifts * node / nodes;
+			const int last = (long long)nr_shifts * (node + 1) / nodes;
+			if (first == last)
+				continue;
+			try
+			{
+#ifdef _OPENMP
+				omp_set_num_threads(threads_per_node);
+#endif
+				// The nested team includes this thread.
+				const NumaTeamUnpin unpin;
+				numa_pin_thread(node);
+				// Pin the nested team before the copies are made and the engines run.
+#pragma omp parallel
+				numa_pin_thread(node);
+				const NumaArray<Index> X(beginX, size, node);
+				const NumaArray<Index> Y(beginY, size, node);
+				shifted_mutual_information_from_indices(
+					shift_from + first * shift_step, shift_from + (last - 1) * shift_step,
+					binsX, binsY, minX, maxX, minY, maxY,
+					X.data(), X.data() + size, Y.data(), Y.data() + size,
+					shift_step, output + first, engine, correction, raw ? raw + first : nullptr,
+					entropies ? entropies + 3 * first : nullptr);
+			}
+			catch (...)
+			{
+#pragma omp critical
+				error = std::current_exception();
+			}
 		}
-		result[(i - shift_from) / shift_step] = *hist.calculate_mutual_information();
+#ifdef _OPENMP
+		omp_set_max_active_levels(max_levels);
+#endif
+		if (error)
+			std::rethrow_exception(error);
 	}
-	return result;
 }
 
-template<typename T, typename Iterator>
+template<typename T, typename Iterator, typename Rng>
 std::vector<T> bootstrapped_mi(const Iterator beginX, const Iterator endX,
 	const Iterator beginY, const Iterator endY,
 	const int binsX, const int binsY,
 	const T minX, const T maxX, const T minY, const T maxY,
-	int nr_samples, int nr_repetitions, std::mt19937& rgen)
+	int nr_samples, int nr_repetitions, Rng& rgen)
+{
+	if (needs_wide_counts(std::distance(beginX, endX)))
+	{
+		BootstrapArena<long long> arena;
+		return bootstrapped_mi_with_counts(beginX, endX, beginY, endY,
+			binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen, arena);
+	}
+	BootstrapArena<int> arena;
+	return bootstrapped_mi_with_counts(beginX, endX, beginY, endY,
+		binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen, arena);
+}
+
+template<typename Count, typename T, typename Iterator, typename Rng>
+std::vector<T> bootstrapped_mi_with_counts(const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	int nr_samples, int nr_repetitions, Rng& rgen,
+	BootstrapArena<Count>& arena)
 {
 	size_t sizeX = std::distance(beginX, endX);
 	size_t sizeY = std::distance(beginY, endY);
 	if (sizeX != sizeY)
 		throw std::logic_error("Containers referenced by iterators must have the same size.");
-	std::uniform_int_distribution<int> uniform(0, sizeX - 1);
-	std::vector<Histogram2d<T>*> hist3d(nr_samples); // A vector of raw pointers :(
-	int nr_samples_per_histogram = sizeX / nr_samples;
+	typedef typename std::iterator_traits<Iterator>::value_type Index;
+	// Repetitions are summed up in blocks of this many histograms.
+	const int block = std::min(nr_repetitions, bootstrap_repetition_block);
+	arena.reset(nr_samples, binsX, binsY, block);
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	const std::size_t nr_samples_per_histogram = sizeX / nr_samples;
+	// Sampled pairs are collected in batches so the histogram kernels can be used.
+	const std::size_t batch_size = std::min(nr_samples_per_histogram, std::size_t(4096));
+	std::vector<Index> batchX(batch_size);
+	std::vector<Index> batchY(batch_size);
+	std::vector<std::size_t> ridx(batch_size);
 	// First create some histograms from randomly sampled data pairs.
 	for (int sample = 0; sample < nr_samples; ++sample)
 	{
-		Histogram2d<T>* hist_ptr = new Histogram2d<T>(binsX, binsY, minX, maxX, minY, maxY);
-		for (int i = 0; i < nr_samples_per_histogram; ++i)
+		Count* H = arena.sample(sample);
+		bootstrap_stream(rgen, STREAM_SAMPLE, sample);
+		for (std::size_t i = 0; i < nr_samples_per_histogram; i += batch_size)
 		{
-			int ridx = uniform(rgen);
-			hist_ptr->increment_at(beginX[ridx], beginY[ridx]);
+			const std::size_t n = std::min(batch_size, nr_samples_per_histogram - i);
+			draw_bounded(rgen, sizeX, ridx.data(), n);
+			for (std::size_t b = 0; b < n; ++b)
+			{
+				batchX[b] = beginX[ridx[b]];
+				batchY[b] = beginY[ridx[b]];
+			}
+			increment_histogram_2d(H, binsX, binsY, batchX.data(), batchY.data(), n, arena.scratch());
 		}
-		hist3d[sample] = hist_ptr;
 	}
-	// Now sample these histograms again and add them together.
-	std::uniform_int_distribution<int> uniform_from_samples(0, nr_samples - 1);
+	// Now sample these histograms again and add them together: the multiplicities of
+	// the sampled histograms in a block of repetitions times the sampled histograms.
+	std::vector<int> picks(nr_samples);
+	std::vector<int> multiplicities(std::size_t(block) * nr_samples);
 	std::vector<T> results(nr_repetitions);
-	for (int i = 0; i < nr_repetitions; ++i)
+	for (int first = 0; first < nr_repetitions; first += block)
 	{
-		Histogram2d<T> final_hist(binsX, binsY, minX, maxX, minY, maxY);
-		for (int sample = 0; sample < nr_samples; ++sample)
+		const int rows = std::min(block, nr_repetitions - first);
+		std::fill(multiplicities.begin(), multiplicities.end(), 0);
+		for (int r = 0; r < rows; ++r)
+		{
+			bootstrap_stream(rgen, STREAM_REPETITION, first + r);
+			draw_bounded(rgen, std::size_t(nr_samples), picks.data(), picks.size());
+			for (int pick : picks)
+			{
+				++multiplicities[std::size_t(r) * nr_samples + pick];
+			}
+		}
+		combine_histograms(multiplicities.data(), rows, arena.sample(0), nr_samples, cells, arena.total(0));
+		for (int r = 0; r < rows; ++r)
 		{
-			int sampleidx = uniform_from_samples(rgen);
-			final_hist.add(*hist3d[sampleidx]);
+			results[first + r] = mutual_information_from_joint_counts<T>(arena.total(r), binsX, binsY,
+				arena.marginalX(), arena.marginalY());
 		}
-		results[i] = *final_hist.calculate_mutual_information();
 	}
-	// Cleanup (even though using raw pointers is not really elegant)
-	for (int sample = 0; sample < nr_samples; ++sample)
+	return results;
+}
+
+template<typename Count, typename T, typename Iterator, typename Rng>
+std::vector<T> multinomial_bootstrapped_mi_with_counts(const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	const int binsX, const int binsY,
+	int nr_repetitions, Rng& rgen,
+	BootstrapArena<Count>& arena)
+{
+	size_t sizeX = std::distance(beginX, endX);
+	size_t sizeY = std::distance(beginY, endY);
+	if (sizeX != sizeY)
+		throw std::logic_error("Containers referenced by iterators must have the same size.");
+	// The observed histogram is the only sample, the replicates are drawn into total.
+	arena.reset(1, binsX, binsY);
+	const std::size_t cells = std::size_t(binsX) * binsY;
+	Count* H = arena.sample(0);
+	increment_histogram_2d(H, binsX, binsY, &*beginX, &*beginY, sizeX, arena.scratch());
+	long long count = 0;
+	for (std::size_t j = 0; j < cells; ++j)
+	{
+		count += H[j];
+	}
+	std::vector<T> results(nr_repetitions);
+	Count* total = arena.total();
+	for (int i = 0; i < nr_repetitions; ++i)
 	{
-		delete hist3d[sample];
+		bootstrap_stream(rgen, STREAM_REPETITION, i);
+		draw_multinomial(rgen, H, cells, count, total);
+		results[i] = mutual_information_from_joint_counts<T>(total, binsX, binsY,
+			arena.marginalX(), arena.marginalY());
 	}
 	return results;
 }
 
+template<typename Count, typename T, typename Index>
+void bootstrap_shifts(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Index* X, const Index* Y, const std::size_t size,
+	int nr_samples, int nr_repetitions,
+	const int shift_step,
+	T* output,
+	const BootstrapRng rng,
+	const uint64_t seed,
+	const BootstrapMode mode)
+{
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	const long long n = size;
+#pragma omp parallel
+	{
+		// The sub-histograms of all shifts of this thread share one arena.
+		BootstrapArena<Count> arena;
+#pragma omp for
+		for (int s = 0; s < nr_shifts; ++s)
+		{
+			// Shift i pairs X[k] with Y[k - i] for k in [max(0, i), n + min(0, i)).
+			const long long i = shift_from + (long long)s * shift_step;
+			const long long begin = std::max(0LL, i);
+			const long long end = n + std::min(0LL, i);
+			std::vector<T> mi;
+			if (rng == RNG_MT19937)
+			{
+				std::mt19937 rgen(std::uint_fast32_t(shift_seed(seed, int(i))));
+				mi = mode == BOOTSTRAP_MULTINOMIAL
+					? multinomial_bootstrapped_mi_with_counts<Count, T>(X + begin, X + end, Y + (begin - i), Y + (end - i),
+						binsX, binsY, nr_repetitions, rgen, arena)
+					: bootstrapped_mi_with_counts(X + begin, X + end, Y + (begin - i), Y + (end - i),
+						binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen, arena);
+			}
+			else if (rng == RNG_XOSHIRO256PP)
+			{
+				Xoshiro256pp rgen(shift_seed(seed, int(i)));
+				mi = mode == BOOTSTRAP_MULTINOMIAL
+					? multinomial_bootstrapped_mi_with_counts<Count, T>(X + begin, X + end, Y + (begin - i), Y + (end - i),
+						binsX, binsY, nr_repetitions, rgen, arena)
+					: bootstrapped_mi_with_counts(X + begin, X + end, Y + (begin - i), Y + (end - i),
+						binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen, arena);
+			}
+			else
+			{
+				Philox4x32 rgen(seed, int(i));
+				mi = mode == BOOTSTRAP_MULTINOMIAL
+					? multinomial_bootstrapped_mi_with_counts<Count, T>(X + begin, X + end, Y + (begin - i), Y + (end - i),
+						binsX, binsY, nr_repetitions, rgen, arena)
+					: bootstrapped_mi_with_counts(X + begin, X + end, Y + (begin - i), Y + (end - i),
+						binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen, arena);
+			}
+			std::copy(mi.begin(), mi.end(), output + std::size_t(s) * nr_repetitions);
+		}
+	}
+}
+
 template<typename T, typename Iterator>
 std::vector< std::vector<T> > shifted_mutual_information_with_bootstrap(
 	const int shift_from, const int shift_to,
@@ -400,7 +953,10 @@ std::vector< std::vector<T> > shifted_mutual_information_with_bootstrap(
 	const Iterator beginX, const Iterator endX,
 	const Iterator beginY, const Iterator endY,
 	int nr_samples, int nr_repetitions,
-	const int shift_step /* 1 */)
+	const int shift_step /* 1 */,
+	const BootstrapRng rng /* RNG_XOSHIRO256PP */,
+	const uint64_t seed /* clock_seed() */,
+	const BootstrapMode mode /* BOOTSTRAP_HISTOGRAMS */)
 {
 	size_t sizeX = std::distance(beginX, endX);
 	size_t sizeY = std::distance(beginY, endY);
@@ -410,89 +966,91 @@ std::vector< std::vector<T> > shifted_mutual_information_with_bootstrap(
 		throw std::logic_error("For bootstrapping you need a minimum of one sample.");
 	if (nr_repetitions < 1)
 		throw std::logic_error("There needs to be at least one repetition of the bootstrapping process.");
-	std::vector<int> indicesX = calculate_indices_1d(binsX, minX, maxX, beginX, endX);
-	std::vector<int> indicesY = calculate_indices_1d(binsY, minY, maxY, beginY, endY);
-	auto indX_begin = indicesX.begin();
-	auto indX_end = indicesX.end();
-	auto indY_begin = indicesY.begin();
-	auto indY_end = indicesY.end();
-	std::vector< std::vector<T> > result((shift_to - shift_from) / shift_step + 1);
-#pragma omp parallel for
-	for (int i = shift_from; i <= shift_to; i += shift_step)
+	switch (index_width(std::max(binsX, binsY)))
 	{
-		unsigned int seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-		std::mt19937 rgen(seed);
-		std::vector<T> mi;
-		if (i < 0)
-		{
-			mi = bootstrapped_mi<T>(indX_begin, std::prev(indX_end, -i),
-				std::next(indY_begin, -i), indY_end,
-				binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen);
-		}
-		else if (i > 0)
-		{
-			mi = bootstrapped_mi<T>(std::next(indX_begin, i), indX_end,
-				indY_begin, std::prev(indY_end, i),
-				binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen);
-		}
-		else // Should not be necessary but better be explicit.
-		{
-			mi = bootstrapped_mi<T>(indX_begin, indX_end,
-				indY_begin, indY_end,
-				binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen);
-		}
-		result[(i - shift_from) / shift_step] = mi;
+	case 1:
+		return shifted_mutual_information_with_bootstrap_binned<uint8_t>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			beginX, endX, beginY, endY, nr_samples, nr_repetitions, shift_step, rng, seed, mode);
+	case 2:
+		return shifted_mutual_information_with_bootstrap_binned<uint16_t>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			beginX, endX, beginY, endY, nr_samples, nr_repetitions, shift_step, rng, seed, mode);
+	default:
+		return shifted_mutual_information_with_bootstrap_binned<int>(shift_from, shift_to,
+			binsX, binsY, minX, maxX, minY, maxY,
+			beginX, endX, beginY, endY, nr_samples, nr_repetitions, shift_step, rng, seed, mode);
+	}
+}
+
+template<typename Index, typename T, typename Iterator>
+std::vector< std::vector<T> > shifted_mutual_information_with_bootstrap_binned(
+	const int shift_from, const int shift_to,
+	const int binsX, const int binsY,
+	const T minX, const T maxX, const T minY, const T maxY,
+	const Iterator beginX, const Iterator endX,
+	const Iterator beginY, const Iterator endY,
+	int nr_samples, int nr_repetitions,
+	const int shift_step,
+	const BootstrapRng rng,
+	const uint64_t seed,
+	const BootstrapMode mode)
+{
+	std::vector<Index> indicesX = calculate_indices_1d<Index>(binsX, minX, maxX, beginX, endX);
+	std::vector<Index> indicesY = calculate_indices_1d<Index>(binsY, minY, maxY, beginY, endY);
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	std::vector<T> output(std::size_t(nr_shifts) * nr_repetitions);
+	shifted_mutual_information_with_bootstrap(shift_from, shift_to,
+		binsX, binsY, minX, maxX, minY, maxY,
+		indicesX.data(), indicesX.data() + indicesX.size(),
+		indicesY.data(), indicesY.data() + indicesY.size(),
+		nr_samples, nr_repetitions, shift_step, output.data(), rng, seed, mode);
+	std::vector< std::vector<T> > result(nr_shifts);
+	for (int s = 0; s < nr_shifts; ++s)
+	{
+		result[s].assign(output.begin() + std::size_t(s) * nr_repetitions,
+			output.begin() + std::size_t(s + 1) * nr_repetitions);
 	}
 	return result;
 }
 
-template<typename T>
+template<typename T, typename Index>
 void shifted_mutual_information(
 	const int shift_from, const int shift_to,
 	const int binsX, const int binsY,
 	const T minX, const T maxX, const T minY, const T maxY,
-	const int* beginX, const int* endX,
-	const int* beginY, const int* endY,
+	const Index* beginX, const Index* endX,
+	const Index* beginY, const Index* endY,
 	const int shift_step,
-	T* output)
+	T* output,
+	const ShiftEngine engine /* ENGINE_AUTO */,
+	const BiasCorrection correction /* BIAS_NONE */,
+	T* raw /* nullptr */,
+	T* entropies /* nullptr */)
 {
 	size_t sizeX = std::distance(beginX, endX);
 	size_t sizeY = std::distance(beginY, endY);
 	check_shifted_mutual_information(sizeX, sizeY, shift_from, shift_to,
 		binsX, binsY, minX, maxX, minY, maxY, shift_step);
-#pragma omp parallel for
-	for (int i = shift_from; i <= shift_to; i += shift_step)
-	{
-		Histogram2d<T> hist(binsX, binsY, minX, maxX, minY, maxY);
-		if (i < 0)
-		{
-			hist.increment_cpu(beginX, std::prev(endX, -i),
-				std::next(beginY, -i), endY);
-		}
-		else if (i > 0)
-		{
-			hist.increment_cpu(std::next(beginX, i), endX,
-				beginY, std::prev(endY, i));
-		}
-		else // Should not be necessary but better be explicit.
-		{
-			hist.increment_cpu(beginX, endX,
-				beginY, endY);
-		}
-		output[(i - shift_from) / shift_step] = *hist.calculate_mutual_information();
-	}
+	shifted_mutual_information_from_indices(shift_from, shift_to,
+		binsX, binsY, minX, maxX, minY, maxY,
+		beginX, endX, beginY, endY,
+		shift_step, output, engine, correction, raw, entropies);
 }
 
-template<typename T>
+template<typename T, typename Index>
 void shifted_mutual_information_with_bootstrap(
 	const int shift_from, const int shift_to,
 	const int binsX, const int binsY,
 	const T minX, const T maxX, const T minY, const T maxY,
-	const int* beginX, const int* endX,
-	const int* beginY, const int* endY,
+	const Index* beginX, const Index* endX,
+	const Index* beginY, const Index* endY,
 	int nr_samples, int nr_repetitions,
 	const int shift_step,
-	T* output)
+	T* output,
+	const BootstrapRng rng /* RNG_XOSHIRO256PP */,
+	const uint64_t seed /* clock_seed() */,
+	const BootstrapMode mode /* BOOTSTRAP_HISTOGRAMS */)
 {
 	size_t sizeX = std::distance(beginX, endX);
 	size_t sizeY = std::distance(beginY, endY);
@@ -502,33 +1060,10 @@ void shifted_mutual_information_with_bootstrap(
 		throw std::logic_error("For bootstrapping you need a minimum of one sample.");
 	if (nr_repetitions < 1)
 		throw std::logic_error("There needs to be at least one repetition of the bootstrapping process.");
-#pragma omp parallel for
-	for (int i = shift_from; i <= shift_to; i += shift_step)
-	{
-		unsigned int seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-		std::mt19937 rgen(seed);
-		std::vector<T> mi;
-		if (i < 0)
-		{
-			mi = bootstrapped_mi<T>(beginX, std::prev(endX, -i),
-				std::next(beginY, -i), endY,
-				binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen);
-		}
-		else if (i > 0)
-		{
-			mi = bootstrapped_mi<T>(std::next(beginX, i), endX,
-				beginY, std::prev(endY, i),
-				binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen);
-		}
-		else // Should not be necessary but better be explicit.
-		{
-			mi = bootstrapped_mi<T>(beginX, endX,
-				beginY, endY,
-				binsX, binsY, minX, maxX, minY, maxY, nr_samples, nr_repetitions, rgen);
-		}
-		for (int j = 0; j < nr_repetitions; ++j) // Copy result to output.
-		{
-			output[((i - shift_from) / shift_step) * nr_repetitions + j] = mi[j];
-		}
-	}
+	if (needs_wide_counts(sizeX))
+		bootstrap_shifts<long long>(shift_from, shift_to, binsX, binsY, minX, maxX, minY, maxY,
+			beginX, beginY, sizeX, nr_samples, nr_repetitions, shift_step, output, rng, seed, mode);
+	else
+		bootstrap_shifts<int>(shift_from, shift_to, binsX, binsY, minX, maxX, minY, maxY,
+			beginX, beginY, sizeX, nr_samples, nr_repetitions, shift_step, output, rng, seed, mode);
 }
\ No newline at end of file
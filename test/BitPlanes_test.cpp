@@ -0,0 +1,75 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cstdint>
+#include "../src/BitPlanes.h"
+
+TEST_CASE( "Bit planes of indices", "[BitPlanes]" )
+{
+	std::vector<uint8_t> indices(130, 255);
+	indices[0] = 1;
+	indices[63] = 1;
+	indices[64] = 0;
+	indices[129] = 2;
+	BitPlanes planes(3, indices.data(), indices.size());
+	REQUIRE( planes.getBins() == 3 );
+	REQUIRE( planes.getWords() == 3 );
+	CHECK( planes[0][0] == 0 );
+	CHECK( planes[0][1] == 1 );
+	CHECK( planes[1][0] == ((uint64_t(1) << 63) | 1) );
+	CHECK( planes[2][2] == 2 );
+	CHECK( and_popcount(planes[1], planes[1], 3) == 2 );
+	CHECK( and_popcount(planes[0], planes[1], 3) == 0 );
+}
+
+TEST_CASE( "Shifted bit planes", "[BitPlanes_shifted]" )
+{
+	std::vector<int> indices(200);
+	for (std::size_t k = 0; k < indices.size(); ++k)
+	{
+		indices[k] = (k * k) % 7 == 1;
+	}
+	BitPlanes planes(2, indices.data(), indices.size());
+	const long long shifts[] {0, 1, 63, 64, 65, 130, -1, -63, -64, -65, -199, 199};
+	for (long long shift : shifts)
+	{
+		std::vector<uint64_t> out(5);
+		planes.shifted(1, shift, 0, 4, out.data());
+		for (long long k = 0; k < 256; ++k)
+		{
+			const long long src = k - shift;
+			const bool expected = src >= 0 && src < 200 && indices[src] == 1;
+			REQUIRE( bool((out[k / 64] >> (k % 64)) & 1) == expected );
+		}
+		// A window starting in the middle of the plane.
+		planes.shifted(1, shift, 2, 1, out.data() + 4);
+		CHECK( out[4] == out[2] );
+	}
+}
+
+TEST_CASE( "Popcount of 64-bit words", "[popcount64]" )
+{
+	CHECK( popcount64(0) == 0 );
+	CHECK( popcount64(~uint64_t(0)) == 64 );
+	CHECK( popcount64(0x8000000000000001ull) == 2 );
+	std::vector<uint64_t> a(21, 0xF0F0F0F0F0F0F0F0ull);
+	std::vector<uint64_t> b(21, 0xFF00FF00FF00FF00ull);
+	CHECK( and_popcount(a.data(), b.data(), a.size()) == 21 * 16 );
+}
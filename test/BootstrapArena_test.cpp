@@ -0,0 +1,115 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "../src/utilities.h"
+
+TEST_CASE( "Bootstrap arena only grows and hands out zeroed histograms", "[BootstrapArena]" )
+{
+	BootstrapArena<int> arena;
+	arena.reset(10, 8, 4);
+	const std::size_t capacity = arena.getCapacity();
+	REQUIRE( capacity >= 11 * 8 * 4 + 8 + 4 );
+	CHECK( arena.sample(1) - arena.sample(0) == 8 * 4 );
+	CHECK( arena.total() == arena.sample(10) );
+	CHECK( arena.marginalY() - arena.marginalX() == 8 );
+	arena.reset(10, 8, 4, 3);
+	CHECK( arena.total(2) - arena.total(0) == 2 * 8 * 4 );
+	CHECK( arena.marginalX() == arena.total(3) );
+	const std::size_t capacity_with_totals = arena.getCapacity();
+	CHECK( capacity_with_totals > capacity );
+	for (int s = 0; s < 10; ++s)
+	{
+		arena.sample(s)[3] = s + 1;
+	}
+	arena.reset(2, 3, 3);
+	CHECK( arena.getCapacity() == capacity_with_totals );
+	CHECK( arena.sample(1) - arena.sample(0) == 9 );
+	for (int s = 0; s < 3; ++s)
+	{
+		for (int i = 0; i < 9; ++i)
+		{
+			REQUIRE( arena.sample(s)[i] == 0 );
+		}
+	}
+}
+
+TEST_CASE( "Bootstrapping with a reused arena", "[bootstrapped_mi_with_counts]" )
+{
+	std::vector<uint8_t> X(3000);
+	std::vector<uint8_t> Y(3000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = uint8_t((i / 7) % 6);
+		Y[i] = uint8_t((i / 5 + i % 3) % 5);
+	}
+	std::mt19937 rgen1(7);
+	BootstrapArena<int> fresh;
+	std::vector<float> expected = bootstrapped_mi_with_counts(X.data(), X.data() + X.size(),
+		Y.data(), Y.data() + Y.size(), 6, 5, 0.f, 1.f, 0.f, 1.f, 20, 30, rgen1, fresh);
+	// The arena has been used for larger histograms before.
+	std::mt19937 rgen2(7);
+	BootstrapArena<int> reused;
+	reused.reset(50, 16, 16);
+	std::fill(reused.sample(0), reused.sample(0) + 50 * 16 * 16, 3);
+	std::vector<float> result = bootstrapped_mi_with_counts(X.data(), X.data() + X.size(),
+		Y.data(), Y.data() + Y.size(), 6, 5, 0.f, 1.f, 0.f, 1.f, 20, 30, rgen2, reused);
+	REQUIRE( result.size() == 30 );
+	CHECK( result == expected );
+	for (float mi : result)
+	{
+		CHECK( mi > 0.f );
+	}
+}
+
+TEST_CASE( "Combining histograms is a matrix product", "[combine_histograms]" )
+{
+	const int rows = 7;
+	const int nr_histograms = 5;
+	const std::size_t cells = 1300;
+	std::vector<int> weights(rows * nr_histograms);
+	std::vector<long long> histograms(nr_histograms * cells);
+	std::mt19937 rgen(3);
+	std::uniform_int_distribution<int> weight(0, 3);
+	std::uniform_int_distribution<int> count(0, 1000);
+	for (int& w : weights)
+	{
+		w = weight(rgen);
+	}
+	for (long long& h : histograms)
+	{
+		h = count(rgen);
+	}
+	std::vector<long long> output(rows * cells, -1);
+	combine_histograms(weights.data(), rows, histograms.data(), nr_histograms, cells, output.data());
+	for (int r = 0; r < rows; ++r)
+	{
+		for (std::size_t c = 0; c < cells; ++c)
+		{
+			long long expected = 0;
+			for (int k = 0; k < nr_histograms; ++k)
+			{
+				expected += weights[r * nr_histograms + k] * histograms[k * cells + c];
+			}
+			REQUIRE( output[r * cells + c] == expected );
+		}
+	}
+}
@@ -0,0 +1,63 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include "../src/FFT.h"
+
+TEST_CASE( "FFT matches the discrete Fourier transform", "[FFT]" )
+{
+	const std::size_t n = 64;
+	const double pi = std::acos(-1.);
+	std::vector< std::complex<double> > data(n);
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		data[k] = std::complex<double>(std::sin(0.3 * k), k % 5);
+	}
+	std::vector< std::complex<double> > transformed(data);
+	FFT fft(n);
+	fft.transform(transformed.data());
+	for (std::size_t j = 0; j < n; ++j)
+	{
+		std::complex<double> expected(0., 0.);
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			expected += data[k] * std::polar(1., -2. * pi * double(j * k) / n);
+		}
+		REQUIRE( transformed[j].real() == Approx(expected.real()).margin(1e-9) );
+		REQUIRE( transformed[j].imag() == Approx(expected.imag()).margin(1e-9) );
+	}
+	// The inverse transform is only missing the division by n.
+	fft.transform(transformed.data(), true);
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		REQUIRE( transformed[k].real() / n == Approx(data[k].real()).margin(1e-9) );
+		REQUIRE( transformed[k].imag() / n == Approx(data[k].imag()).margin(1e-9) );
+	}
+}
+
+TEST_CASE( "FFT sizes must be powers of two", "[FFT_sizes]" )
+{
+	CHECK_THROWS_AS( FFT(12), std::invalid_argument& );
+	CHECK_THROWS_AS( FFT(0), std::invalid_argument& );
+	CHECK( FFT::next_power_of_two(1) == 1 );
+	CHECK( FFT::next_power_of_two(1000) == 1024 );
+	CHECK( FFT::next_power_of_two(1024) == 1024 );
+}
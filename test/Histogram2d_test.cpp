@@ -17,8 +17,11 @@
 */
 
 #include <catch.hpp>
+#include <limits>
 #include <vector>
 #include <algorithm>
+#include <numeric>
+#include <cstdint>
 #include "../src/Histogram2d.h"
 #include "../src/utilities.h"
 
@@ -122,4 +125,62 @@ TEST_CASE( "Add two simple histograms", "[Histogram2d_add]" )
 	CHECK( h1[1][0] == 1 );
 	CHECK( h1[0][1] == 1 );
 	CHECK( h1[1][1] == 1 );
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Histograms with 64-bit counts hold more than INT_MAX samples", "[Histogram2d_wide_counts]" )
+{
+	Histogram2d<double, long long> hist(3, 3, 0., 1., 0., 1.);
+	hist.increment_at(0, 0);
+	hist.increment_at(0, 1);
+	hist.increment_at(1, 1);
+	hist.increment_at(2, 2);
+	hist.increment_at(2, 2);
+	const double expected = *hist.calculate_mutual_information();
+	// Doubling every bin leaves the probabilities and hence the mutual information unchanged.
+	for (int i = 0; i < 32; ++i)
+	{
+		hist.add(hist);
+	}
+	REQUIRE( hist.getCount() == 5LL << 32 );
+	CHECK( hist.getCount() > std::numeric_limits<int>::max() );
+	CHECK( hist.getHistogram()[2][2] == 2LL << 32 );
+	CHECK( *hist.calculate_mutual_information() == Approx(expected) );
+}
+
+TEST_CASE( "Reset histogram for reuse", "[Histogram2d_reset]" )
+{
+	Histogram2d<float> hist(3, 3, 0.f, 1.f, 0.f, 1.f);
+	hist.increment_at(0, 0);
+	hist.increment_at(1, 2);
+	CHECK( *hist.calculate_mutual_information() == Approx(1.f) );
+	hist.reset();
+	REQUIRE( hist.getCount() == 0 );
+	for (auto value : hist.getHistogram())
+	{
+		CHECK( value == 0 );
+	}
+	hist.increment_at(2, 2);
+	hist.increment_at(2, 2);
+	REQUIRE( hist.getCount() == 2 );
+	CHECK( hist.reduce1d().first->getHistogram()[2] == 2 );
+	CHECK( *hist.calculate_mutual_information() == Approx(0.f) );
+}
+
+TEST_CASE( "Histogram bins are stored contiguous in row-major order", "[Histogram2d_view]" )
+{
+	Histogram2d<float> hist(4, 3, 0.f, 1.f, 0.f, 1.f);
+	hist.increment_at(0, 2);
+	hist.increment_at(1, 0);
+	hist.increment_at(3, 1);
+	hist.increment_at(3, 1);
+	auto view = hist.getHistogram();
+	REQUIRE( view.size() == 12 );
+	REQUIRE( view.getBinsX() == 4 );
+	REQUIRE( view.getBinsY() == 3 );
+	CHECK( reinterpret_cast<std::uintptr_t>(view.data()) % 64 == 0 );
+	CHECK( view.data()[0 * 3 + 2] == 1 );
+	CHECK( view.data()[1 * 3 + 0] == 1 );
+	CHECK( view.data()[3 * 3 + 1] == 2 );
+	CHECK( view[3] == view.data() + 9 );
+	CHECK( std::accumulate(view.begin(), view.end(), 0) == hist.getCount() );
+}
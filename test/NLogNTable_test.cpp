@@ -0,0 +1,77 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <random>
+#include <cmath>
+#include "../src/NLogNTable.h"
+
+TEST_CASE("NLogNTable holds n * log2(n) and grows on demand", "[NLogNTable]")
+{
+	NLogNTable::Snapshot table = NLogNTable::instance().reserve(100);
+	REQUIRE( table.size > 100 );
+	REQUIRE( table.data[0] == 0. );
+	REQUIRE( table.data[1] == 0. );
+	REQUIRE( table.data[8] == Approx(24.) );
+	NLogNTable::Snapshot larger = NLogNTable::instance().reserve(table.size + 10);
+	REQUIRE( larger.size > table.size + 10 );
+	REQUIRE( larger.data[table.size + 5] == Approx(NLogNTable::nlogn(double(table.size + 5))) );
+	NLogNTable::Snapshot capped = NLogNTable::instance().reserve(NLogNTable::max_size * 4);
+	REQUIRE( capped.size == std::size_t(NLogNTable::max_size) );
+}
+
+TEST_CASE("sum_nlogn handles counts beyond the table", "[NLogNTable]")
+{
+	std::vector<int> counts {0, 1, 2, 3, 4, 5, 6, 7, 100000, 12, 13, 14, 1 << 28};
+	NLogNTable::Snapshot table = NLogNTable::instance().reserve(20);
+	double expected = 0;
+	for (int n : counts)
+		expected += NLogNTable::nlogn(double(n));
+	REQUIRE( sum_nlogn(counts.data(), counts.size(), table) == Approx(expected) );
+}
+
+TEST_CASE("Mutual information from counts matches the probability formula", "[NLogNTable]")
+{
+	const int binsX = 7, binsY = 5;
+	std::mt19937 rgen(3);
+	std::uniform_int_distribution<int> dist(0, 50);
+	std::vector<int> H(binsX * binsY);
+	std::vector<int> hX(binsX, 0), hY(binsY, 0);
+	long long count = 0;
+	for (int x = 0; x < binsX; ++x)
+		for (int y = 0; y < binsY; ++y)
+		{
+			const int n = (x + y) % 3 == 0 ? dist(rgen) : 0;
+			H[x * binsY + y] = n;
+			hX[x] += n;
+			hY[y] += n;
+			count += n;
+		}
+	double expected = 0;
+	for (int x = 0; x < binsX; ++x)
+		for (int y = 0; y < binsY; ++y)
+		{
+			const int n = H[x * binsY + y];
+			if (n > 0)
+				expected += double(n) / count * std::log2(double(n) * count / (double(hX[x]) * hY[y]));
+		}
+	REQUIRE( mutual_information_from_counts<double>(H.data(), hX.data(), hY.data(), binsX, binsY, count)
+		== Approx(expected) );
+	REQUIRE( mutual_information_from_counts<float>(H.data(), hX.data(), hY.data(), binsX, binsY, 0) == 0.f );
+}
@@ -0,0 +1,67 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include "../src/ShiftedMutualInformationStream.h"
+
+TEST_CASE( "Streaming gives the same results as the whole data", "[ShiftedMutualInformationStream]" )
+{
+	std::vector<double> X(3000);
+	std::vector<double> Y(3000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = std::sin(0.01 * i) + 0.3 * std::sin(0.7 * i);
+		Y[i] = std::cos(0.013 * i);
+	}
+	X[100] = 5.; // Out of range.
+	ShiftedMutualInformationStream<double, uint8_t> stream(-120, 77, 9, 7, -1.3, 1.3, -1., 1., 3);
+	REQUIRE( stream.getNrShifts() == 66 );
+	// Blocks smaller and larger than the largest shift.
+	const std::size_t blocks[] {1, 50, 0, 119, 300, 7, 1000, 523, 1000};
+	std::size_t position = 0;
+	for (std::size_t block : blocks)
+	{
+		stream.append(X.begin() + position, X.begin() + position + block,
+			Y.begin() + position, Y.begin() + position + block);
+		position += block;
+		REQUIRE( stream.size() == position );
+		if (position > 120)
+		{
+			auto expected = shifted_mutual_information(-120, 77, 9, 7, -1.3, 1.3, -1., 1.,
+				X.begin(), X.begin() + position, Y.begin(), Y.begin() + position, 3, ENGINE_PER_SHIFT);
+			CHECK( stream.mutual_information() == expected );
+		}
+	}
+	REQUIRE( position == X.size() );
+}
+
+TEST_CASE( "Streaming with invalid arguments", "[ShiftedMutualInformationStream_arguments]" )
+{
+	CHECK_THROWS_AS( (ShiftedMutualInformationStream<float, uint8_t>(-5, 5, 300, 4, 0.f, 1.f, 0.f, 1.f)),
+		std::invalid_argument& );
+	CHECK_THROWS_AS( (ShiftedMutualInformationStream<float>(5, 5, 3, 4, 0.f, 1.f, 0.f, 1.f)),
+		std::logic_error& );
+	ShiftedMutualInformationStream<float> stream(-5, 5, 3, 4, 0.f, 1.f, 0.f, 1.f);
+	std::vector<float> X(10), Y(9);
+	CHECK_THROWS_AS( stream.append(X.begin(), X.end(), Y.begin(), Y.end()), std::logic_error& );
+	// Without data all values are zero.
+	CHECK( stream.mutual_information() == std::vector<float>(11, 0.f) );
+}
@@ -60,4 +60,21 @@ TEST_CASE( "Write and read a 64bit binary file.", "[SimpleBinaryFileDouble]" )
     REQUIRE( file1f_data.size() == 1000 );
     CHECK( file1f_data[0] == 0.f );
     CHECK( file1f_data[999] == 999.f );
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Read binary files in chunks", "[SimpleBinaryFile_readChunk]" )
+{
+    SimpleBinaryFile<float> file("test/SimpleBinaryFile_data2.bin", PREC_64);
+    std::vector<float> chunk;
+    REQUIRE( file.readChunk(chunk, 300) == 300 );
+    CHECK( chunk[0] == 0.f );
+    REQUIRE( file.readChunk(chunk, 300) == 300 );
+    CHECK( chunk[0] == 300.f );
+    file.readChunk(chunk, 300);
+    REQUIRE( file.readChunk(chunk, 300) == 100 );
+    CHECK( chunk[99] == 999.f );
+    CHECK( file.readChunk(chunk, 300) == 0 );
+    file.rewind();
+    REQUIRE( file.readChunk(chunk, 1) == 1 );
+    CHECK( chunk[0] == 0.f );
+}
@@ -17,6 +17,7 @@
 */
 
 #include <catch.hpp>
+#include <vector>
 #include "../src/SimpleCSV.h"
 
 TEST_CASE( "Test reading of CSV files with space delimiter", "[SimpleCSV]" )
@@ -38,5 +39,19 @@ TEST_CASE( "Test reading of CSV files with space delimiter", "[SimpleCSV]" )
 	REQUIRE( random2.size() == 10000 );
 }
 
-
-
+TEST_CASE( "Read CSV files in chunks", "[SimpleCSV_readChunk]" )
+{
+	SimpleCSV<float> csv("test/SimpleCSV_random1.csv");
+	std::vector<float> chunk;
+	std::vector<float> all;
+	while (csv.readChunk(chunk, 999) > 0)
+	{
+		REQUIRE( chunk.size() <= 999 );
+		all.insert(all.end(), chunk.begin(), chunk.end());
+	}
+	CHECK( all == csv.getData() );
+	csv.rewind();
+	REQUIRE( csv.readChunk(chunk, 2) == 2 );
+	CHECK( chunk[0] == all[0] );
+	CHECK( chunk[1] == all[1] );
+}
@@ -0,0 +1,98 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "../src/all_pairs.h"
+
+static std::vector< std::vector<float> > make_channels(const int nr_channels, const std::size_t size)
+{
+	std::vector< std::vector<float> > channels(nr_channels, std::vector<float>(size));
+	for (int c = 0; c < nr_channels; ++c)
+	{
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			channels[c][i] = std::sin(0.01f * (c + 1) * i + c) + 0.3f * std::cos(0.37f * i * (c + 2));
+		}
+	}
+	return channels;
+}
+
+static void check_all_pairs(const int shift_from, const int shift_to, const int bins, const int shift_step)
+{
+	auto channels = make_channels(5, 1500);
+	const int nr_channels = int(channels.size());
+	const int nr_shifts = (shift_to - shift_from) / shift_step + 1;
+	auto tensor = all_pairs_shifted_mutual_information(shift_from, shift_to, bins, channels,
+		std::vector<float>(), std::vector<float>(), shift_step);
+	REQUIRE( tensor.size() == std::size_t(nr_channels * nr_channels * nr_shifts) );
+	for (int i = 0; i < nr_channels; ++i)
+	{
+		for (int j = 0; j < nr_channels; ++j)
+		{
+			auto minmaxX = std::minmax_element(channels[i].begin(), channels[i].end());
+			auto minmaxY = std::minmax_element(channels[j].begin(), channels[j].end());
+			auto expected = shifted_mutual_information(shift_from, shift_to, bins, bins,
+				*minmaxX.first, *minmaxX.second, *minmaxY.first, *minmaxY.second,
+				channels[i].begin(), channels[i].end(), channels[j].begin(), channels[j].end(),
+				shift_step, ENGINE_PER_SHIFT);
+			for (int k = 0; k < nr_shifts; ++k)
+			{
+				CHECK( tensor[(i * nr_channels + j) * nr_shifts + k] == Approx(expected[k]) );
+			}
+		}
+	}
+}
+
+TEST_CASE( "All pairs give the same results as single pairs", "[all_pairs_shifted_mutual_information]" )
+{
+	SECTION( "symmetric shifts" )
+	{
+		check_all_pairs(-20, 20, 10, 1);
+	}
+	SECTION( "asymmetric shifts with steps" )
+	{
+		check_all_pairs(-6, 11, 300, 3);
+	}
+	SECTION( "shifts without mirrors" )
+	{
+		check_all_pairs(-7, 8, 4, 2);
+	}
+}
+
+TEST_CASE( "All pairs with given ranges", "[all_pairs_shifted_mutual_information_ranges]" )
+{
+	auto channels = make_channels(3, 500);
+	std::vector<float> mins(3, -1.f);
+	std::vector<float> maxs(3, 1.f);
+	auto tensor = all_pairs_shifted_mutual_information(-5, 5, 8, channels, mins, maxs);
+	auto expected = shifted_mutual_information(-5, 5, 8, 8, -1.f, 1.f, -1.f, 1.f,
+		channels[2].begin(), channels[2].end(), channels[1].begin(), channels[1].end());
+	for (int k = 0; k < 11; ++k)
+	{
+		CHECK( tensor[(2 * 3 + 1) * 11 + k] == Approx(expected[k]) );
+	}
+	CHECK_THROWS_AS( all_pairs_shifted_mutual_information(-5, 5, 8, channels, std::vector<float>(2, 0.f)),
+		std::invalid_argument& );
+	channels[1].pop_back();
+	CHECK_THROWS_AS( all_pairs_shifted_mutual_information(-5, 5, 8, channels), std::logic_error& );
+	CHECK_THROWS_AS( all_pairs_shifted_mutual_information(-5, 5, 8, std::vector< std::vector<float> >()),
+		std::invalid_argument& );
+}
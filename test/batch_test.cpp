@@ -0,0 +1,122 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "../src/batch.h"
+
+TEST_CASE( "Parsing a batch manifest", "[parse_batch_manifest]" )
+{
+	BatchPair<float> defaults {"", "", -5, 5, 1, 10, 10, NAN, NAN, NAN, NAN, "", 0};
+	std::istringstream manifest(
+		"# comment\n"
+		"a.csv b.csv\n"
+		"\n"
+		"a.csv c.csv shift_from=-2 shift_to=8 shift_step=2 bins_x=3 bins_y=300 min1=-1.5 max2=4 outfile=ac.bin\n");
+	auto pairs = parse_batch_manifest(manifest, defaults);
+	REQUIRE( pairs.size() == 2 );
+	CHECK( pairs[0].path1 == "a.csv" );
+	CHECK( pairs[0].path2 == "b.csv" );
+	CHECK( pairs[0].shift_from == -5 );
+	CHECK( pairs[0].line == 2 );
+	CHECK( std::isnan(pairs[0].min1) );
+	CHECK( pairs[1].shift_from == -2 );
+	CHECK( pairs[1].shift_to == 8 );
+	CHECK( pairs[1].shift_step == 2 );
+	CHECK( pairs[1].binsX == 3 );
+	CHECK( pairs[1].binsY == 300 );
+	CHECK( pairs[1].min1 == -1.5f );
+	CHECK( std::isnan(pairs[1].max1) );
+	CHECK( pairs[1].max2 == 4.f );
+	CHECK( pairs[1].outfile == "ac.bin" );
+	CHECK( pairs[1].line == 4 );
+	std::istringstream single("a.csv\n");
+	CHECK_THROWS_AS( parse_batch_manifest(single, defaults), std::invalid_argument& );
+	std::istringstream unknown("a.csv b.csv bins=3\n");
+	CHECK_THROWS_AS( parse_batch_manifest(unknown, defaults), std::invalid_argument& );
+	std::istringstream invalid("a.csv b.csv bins_x=many\n");
+	CHECK_THROWS_AS( parse_batch_manifest(invalid, defaults), std::invalid_argument& );
+}
+
+TEST_CASE( "Batch gives the same results as single pairs", "[batch_shifted_mutual_information]" )
+{
+	std::map<std::string, std::vector<float>> files;
+	for (const char* name : {"x", "y", "z"})
+	{
+		std::vector<float>& data = files[name];
+		data.resize(3000);
+		for (std::size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = std::sin(0.01f * i * (name[0] - 'w')) + 0.2f * std::cos(0.7f * i);
+		}
+	}
+	int loads = 0;
+	auto load = [&files, &loads](const std::string& path) { ++loads; return files.at(path); };
+	BatchPair<float> defaults {"", "", -50, 50, 1, 10, 10, NAN, NAN, NAN, NAN, "", 0};
+	std::istringstream manifest(
+		"x y\n"
+		"x z shift_step=3 bins_y=300\n"
+		"z y shift_from=-10 shift_to=400 min1=-0.5 max1=0.5\n");
+	auto pairs = parse_batch_manifest(manifest, defaults);
+	auto results = batch_shifted_mutual_information(pairs, load);
+	REQUIRE( loads == 3 );
+	REQUIRE( results.size() == 3 );
+	for (std::size_t p = 0; p < pairs.size(); ++p)
+	{
+		const std::vector<float>& X = files.at(pairs[p].path1);
+		const std::vector<float>& Y = files.at(pairs[p].path2);
+		auto expected = shifted_mutual_information(pairs[p].shift_from, pairs[p].shift_to,
+			pairs[p].binsX, pairs[p].binsY, pairs[p].min1, pairs[p].max1, pairs[p].min2, pairs[p].max2,
+			X.begin(), X.end(), Y.begin(), Y.end(), pairs[p].shift_step, ENGINE_PER_SHIFT);
+		REQUIRE( results[p].size() == expected.size() );
+		for (std::size_t i = 0; i < expected.size(); ++i)
+		{
+			CHECK( results[p][i] == Approx(expected[i]) );
+		}
+	}
+	CHECK( pairs[2].min1 == -0.5f );
+	CHECK( pairs[0].min1 == *std::min_element(files["x"].begin(), files["x"].end()) );
+}
+
+TEST_CASE( "Batch reports the manifest line of invalid pairs", "[batch_shifted_mutual_information_errors]" )
+{
+	std::vector<float> data(100, 1.f);
+	data[0] = 0.f;
+	auto load = [&data](const std::string&) { return data; };
+	BatchPair<float> defaults {"", "", -5, 5, 1, 10, 10, NAN, NAN, NAN, NAN, "", 0};
+	std::istringstream manifest("a b\n\na b shift_to=100\n");
+	auto pairs = parse_batch_manifest(manifest, defaults);
+	try
+	{
+		batch_shifted_mutual_information(pairs, load);
+		FAIL( "no exception" );
+	}
+	catch (const std::logic_error& e)
+	{
+		CHECK( std::string(e.what()).find("manifest line 3") == 0 );
+	}
+	std::istringstream range("a b min1=2 max1=1\n");
+	pairs = parse_batch_manifest(range, defaults);
+	CHECK_THROWS_AS( batch_shifted_mutual_information(pairs, load), std::logic_error& );
+}
@@ -0,0 +1,141 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include "../src/utilities.h"
+
+TEST_CASE( "Miller-Madow bias from the occupied bins", "[mutual_information_bias]" )
+{
+	// 3 x 3 histogram with 5 occupied cells, 3 occupied rows and 2 occupied columns.
+	const std::vector<int> H {4, 0, 1,
+	                          0, 0, 2,
+	                          3, 0, 2};
+	const std::vector<int> hX {5, 2, 5};
+	const std::vector<int> hY {7, 0, 5};
+	const double bias = mutual_information_bias(H.data(), hX.data(), hY.data(), 3, 3, 12, BIAS_MILLER_MADOW);
+	CHECK( bias == Approx((5. - 3. - 2. + 1.) / (2. * 12. * std::log(2.))) );
+	CHECK( mutual_information_bias(H.data(), hX.data(), hY.data(), 3, 3, 12, BIAS_NONE) == 0. );
+	Histogram2d<double> hist(3, 3, 0., 1., 0., 1.);
+	for (int x = 0; x < 3; ++x)
+	{
+		for (int y = 0; y < 3; ++y)
+		{
+			for (int n = 0; n < H[x * 3 + y]; ++n)
+			{
+				hist.increment_at(x, y);
+			}
+		}
+	}
+	double raw = -1.;
+	const double corrected = hist.calculate_corrected_mutual_information(BIAS_MILLER_MADOW, &raw);
+	CHECK( raw == *hist.calculate_mutual_information() );
+	CHECK( corrected == Approx(raw - bias) );
+}
+
+TEST_CASE( "Relevant bins include those likely empty by chance", "[relevant_bins]" )
+{
+	const std::vector<int> full {3, 1, 2, 5};
+	CHECK( relevant_bins(full.data(), 4, 11) == 4 );
+	// Without singletons no probability mass is assumed to be unseen.
+	const std::vector<int> no_singletons {3, 0, 2, 5, 0};
+	CHECK( relevant_bins(no_singletons.data(), 5, 10) == 3 );
+	// Mostly singletons hint at many more bins than observed.
+	std::vector<int> sparse(100, 0);
+	for (int i = 0; i < 20; ++i)
+	{
+		sparse[i] = 1;
+	}
+	const int relevant = relevant_bins(sparse.data(), 100, 20);
+	CHECK( relevant > 20 );
+	CHECK( relevant <= 100 );
+}
+
+TEST_CASE( "Bias corrections reduce the mutual information of independent data", "[shifted_mutual_information_bias]" )
+{
+	std::mt19937 rgen(42);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::vector<float> X(2000);
+	std::vector<float> Y(2000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = uniform(rgen);
+		Y[i] = uniform(rgen);
+	}
+	std::vector<float> raw;
+	std::vector<float> plain = shifted_mutual_information(-20, 20, 12, 12, 0.f, 1.f, 0.f, 1.f,
+		X.begin(), X.end(), Y.begin(), Y.end());
+	std::vector<float> miller_madow = shifted_mutual_information(-20, 20, 12, 12, 0.f, 1.f, 0.f, 1.f,
+		X.begin(), X.end(), Y.begin(), Y.end(), 1, ENGINE_AUTO, NUMA_NONE, BIAS_MILLER_MADOW, &raw);
+	std::vector<float> panzeri_treves = shifted_mutual_information(-20, 20, 12, 12, 0.f, 1.f, 0.f, 1.f,
+		X.begin(), X.end(), Y.begin(), Y.end(), 1, ENGINE_AUTO, NUMA_NONE, BIAS_PANZERI_TREVES);
+	REQUIRE( raw == plain );
+	double mean_plain = 0, mean_mm = 0, mean_pt = 0;
+	for (std::size_t i = 0; i < plain.size(); ++i)
+	{
+		mean_plain += plain[i] / plain.size();
+		mean_mm += miller_madow[i] / plain.size();
+		mean_pt += panzeri_treves[i] / plain.size();
+	}
+	// The true mutual information is 0.
+	CHECK( std::abs(mean_mm) < 0.25 * mean_plain );
+	CHECK( std::abs(mean_pt) < 0.25 * mean_plain );
+}
+
+TEST_CASE( "All engines give the same corrected values", "[shifted_mutual_information_bias_engines]" )
+{
+	std::vector<uint8_t> X(5003);
+	std::vector<uint8_t> Y(5003);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = uint8_t((i * 7 + i / 13) % 5);
+		Y[i] = uint8_t((i * 3 + i / 29) % 6);
+	}
+	const int nr_shifts = 2 * 40 / 3 + 1;
+	std::vector<double> expected(nr_shifts);
+	std::vector<double> expected_raw(nr_shifts);
+	shifted_mutual_information_per_shift(-40, 40, 5, 6, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), 3, expected.data(), BIAS_PANZERI_TREVES, expected_raw.data());
+	std::vector<double> plain(nr_shifts);
+	shifted_mutual_information_per_shift(-40, 40, 5, 6, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), 3, plain.data());
+	CHECK( expected_raw == plain );
+	for (ShiftEngine engine : {ENGINE_TILED, ENGINE_FFT, ENGINE_BITPLANE})
+	{
+		std::vector<double> result(nr_shifts);
+		std::vector<double> raw(nr_shifts);
+		shifted_mutual_information(-40, 40, 5, 6, 0., 1., 0., 1., X.data(), X.data() + X.size(),
+			Y.data(), Y.data() + Y.size(), 3, result.data(), engine, BIAS_PANZERI_TREVES, raw.data());
+		for (int s = 0; s < nr_shifts; ++s)
+		{
+			REQUIRE( result[s] == Approx(expected[s]) );
+			REQUIRE( raw[s] == Approx(expected_raw[s]) );
+		}
+	}
+}
+
+TEST_CASE( "Bias corrections by name", "[bias_correction_from_name]" )
+{
+	CHECK( bias_correction_from_name("none") == BIAS_NONE );
+	CHECK( bias_correction_from_name("miller_madow") == BIAS_MILLER_MADOW );
+	CHECK( bias_correction_from_name("panzeri_treves") == BIAS_PANZERI_TREVES );
+	CHECK_THROWS_AS( bias_correction_from_name("jackknife"), std::invalid_argument& );
+}
@@ -0,0 +1,137 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include "../src/utilities.h"
+
+TEST_CASE( "Bootstrap mode names", "[bootstrap_mode]" )
+{
+	const std::vector<std::string>& names = bootstrap_mode_names();
+	REQUIRE( names.size() == 2 );
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		CHECK( bootstrap_mode_from_name(names[i]) == static_cast<BootstrapMode>(i) );
+	}
+	CHECK_THROWS_AS( bootstrap_mode_from_name("jackknife"), std::invalid_argument& );
+}
+
+/**
+ * Returns zeros first, which std::generate_canonical turns into 0.
+ */
+struct ZerosFirst
+{
+	typedef uint64_t result_type;
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+	result_type operator()() { return zeros-- > 0 ? 0 : rgen(); }
+	int zeros;
+	Xoshiro256pp rgen;
+};
+
+TEST_CASE( "Binomial draws have the right mean and variance", "[draw_binomial]" )
+{
+	Xoshiro256pp rgen(5);
+	CHECK( draw_binomial(rgen, 100, 0.0) == 0 );
+	CHECK( draw_binomial(rgen, 100, 1.0) == 100 );
+	CHECK( draw_binomial(rgen, 0, 0.5) == 0 );
+	// Inversion, rejection and both of them mirrored.
+	const long long trials[] = {20, 20, 100000, 100000};
+	const double probabilities[] = {0.1, 0.9, 0.3, 0.7};
+	const int draws = 20000;
+	for (int t = 0; t < 4; ++t)
+	{
+		const long long n = trials[t];
+		const double p = probabilities[t];
+		double sum = 0;
+		double sum_squares = 0;
+		for (int i = 0; i < draws; ++i)
+		{
+			const long long k = draw_binomial(rgen, n, p);
+			REQUIRE( k >= 0 );
+			REQUIRE( k <= n );
+			sum += k;
+			sum_squares += double(k) * k;
+		}
+		const double mean = sum / draws;
+		const double variance = sum_squares / draws - mean * mean;
+		CHECK( mean == Approx(n * p).epsilon(0.01) );
+		CHECK( variance == Approx(n * p * (1 - p)).epsilon(0.05) );
+	}
+	// Waiting times of zero would count successes beyond n.
+	ZerosFirst zeros {1000, Xoshiro256pp(5)};
+	CHECK( draw_binomial(zeros, 100, 0.01) <= 100 );
+}
+
+TEST_CASE( "Multinomial draws keep the total and the empty bins", "[draw_multinomial]" )
+{
+	const std::vector<int> counts {0, 500, 3, 0, 20000, 1, 0, 1496};
+	const long long total = std::accumulate(counts.begin(), counts.end(), 0LL);
+	std::vector<int> drawn(counts.size());
+	std::vector<double> mean(counts.size());
+	Philox4x32 rgen(11);
+	const int draws = 2000;
+	for (int i = 0; i < draws; ++i)
+	{
+		draw_multinomial(rgen, counts.data(), counts.size(), total, drawn.data());
+		REQUIRE( std::accumulate(drawn.begin(), drawn.end(), 0LL) == total );
+		for (std::size_t c = 0; c < counts.size(); ++c)
+		{
+			if (counts[c] == 0)
+				REQUIRE( drawn[c] == 0 );
+			mean[c] += double(drawn[c]) / draws;
+		}
+	}
+	CHECK( mean[1] == Approx(500).epsilon(0.02) );
+	CHECK( mean[4] == Approx(20000).epsilon(0.01) );
+	CHECK( mean[7] == Approx(1496).epsilon(0.02) );
+}
+
+TEST_CASE( "Multinomial bootstrapping", "[shifted_mutual_information_with_bootstrap]" )
+{
+	std::vector<uint8_t> X(20000);
+	std::vector<uint8_t> Y(20000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = uint8_t((i * 7919) % 101 % 8);
+		Y[i] = i >= 2 ? X[i - 2] : 0;
+	}
+	std::vector<float> plugin(5);
+	shifted_mutual_information(-4, 0, 8, 8, 0.f, 1.f, 0.f, 1.f,
+		X.data(), X.data() + X.size(), Y.data(), Y.data() + Y.size(), 1, plugin.data());
+	const int nr_repetitions = 50;
+	std::vector<float> result(5 * nr_repetitions);
+	shifted_mutual_information_with_bootstrap(-4, 0, 8, 8, 0.f, 1.f, 0.f, 1.f,
+		X.data(), X.data() + X.size(), Y.data(), Y.data() + Y.size(), 1, nr_repetitions, 1,
+		result.data(), RNG_PHILOX, 3, BOOTSTRAP_MULTINOMIAL);
+	for (int s = 0; s < 5; ++s)
+	{
+		const float mean = std::accumulate(result.begin() + s * nr_repetitions,
+			result.begin() + (s + 1) * nr_repetitions, 0.f) / nr_repetitions;
+		// Resampling adds about the plug-in bias of (8 - 1)^2 / (2 N ln 2) to the noise.
+		CHECK( mean >= plugin[s] - 0.005f );
+		CHECK( mean <= plugin[s] + 0.005f );
+	}
+	// The replicates of the fully dependent shift keep the diagonal histogram.
+	CHECK( result[2 * nr_repetitions] == Approx(plugin[2]).epsilon(0.01) );
+	CHECK( plugin[2] > 2.f );
+}
@@ -0,0 +1,210 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <numeric>
+#include "../src/utilities.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+TEST_CASE( "Generator names", "[bootstrap_rng]" )
+{
+	const std::vector<std::string>& names = bootstrap_rng_names();
+	REQUIRE( names.size() == 3 );
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		CHECK( bootstrap_rng_from_name(names[i]) == static_cast<BootstrapRng>(i) );
+	}
+	CHECK_THROWS_AS( bootstrap_rng_from_name("rand"), std::invalid_argument& );
+}
+
+TEST_CASE( "Batches of xoshiro256++ continue the single draws", "[Xoshiro256pp]" )
+{
+	Xoshiro256pp single(42);
+	Xoshiro256pp batched(42);
+	std::vector<uint64_t> expected(103);
+	for (uint64_t& value : expected)
+	{
+		value = single();
+	}
+	std::vector<uint64_t> result(expected.size());
+	result[0] = batched();
+	batched.fill(result.data() + 1, 50);
+	batched.fill(result.data() + 51, 52);
+	CHECK( result == expected );
+	CHECK( Xoshiro256pp(1)() != Xoshiro256pp(2)() );
+}
+
+TEST_CASE( "Bounded integers reject the biased values", "[lemire_bounded]" )
+{
+	uint32_t value = 7;
+	// 2^32 mod 3 = 1, so only a product with low part 0 is rejected.
+	CHECK_FALSE( lemire_bounded(0u, 3u, value) );
+	REQUIRE( lemire_bounded(1u, 3u, value) );
+	CHECK( value == 0 );
+	REQUIRE( lemire_bounded(0xffffffffu, 3u, value) );
+	CHECK( value == 2 );
+	// Powers of two are never rejected.
+	REQUIRE( lemire_bounded(0u, 16u, value) );
+	CHECK( value == 0 );
+}
+
+TEST_CASE( "Bounded integers are uniform", "[draw_bounded]" )
+{
+	const std::size_t range = 10;
+	const std::size_t n = 100001;
+	std::vector<int> counts(range);
+	std::vector<std::size_t> values(n);
+	Xoshiro256pp xoshiro(3);
+	std::mt19937 mt(3);
+	for (int generator = 0; generator < 2; ++generator)
+	{
+		std::fill(counts.begin(), counts.end(), 0);
+		if (generator == 0)
+			draw_bounded(xoshiro, range, values.data(), n);
+		else
+			draw_bounded(mt, range, values.data(), n);
+		for (std::size_t value : values)
+		{
+			REQUIRE( value < range );
+			++counts[value];
+		}
+		for (int count : counts)
+		{
+			CHECK( count > 9500 );
+			CHECK( count < 10500 );
+		}
+	}
+}
+
+TEST_CASE( "Bootstrapping with either generator", "[shifted_mutual_information_with_bootstrap]" )
+{
+	std::vector<float> X(4000);
+	std::vector<float> Y(4000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = float((i * 7919) % 101);
+		Y[i] = i >= 3 ? X[i - 3] : 0.f;
+	}
+	std::vector< std::vector<float> > mean(2);
+	for (int rng = 0; rng < 2; ++rng)
+	{
+		std::vector< std::vector<float> > result = shifted_mutual_information_with_bootstrap(
+			-5, 5, 10, 10, 0.f, 100.f, 0.f, 100.f, X.begin(), X.end(), Y.begin(), Y.end(),
+			20, 10, 1, static_cast<BootstrapRng>(rng));
+		REQUIRE( result.size() == 11 );
+		for (const std::vector<float>& mi : result)
+		{
+			REQUIRE( mi.size() == 10 );
+			mean[rng].push_back(std::accumulate(mi.begin(), mi.end(), 0.f) / mi.size());
+		}
+	}
+	for (int s = 0; s < 11; ++s)
+	{
+		CHECK( mean[0][s] == Approx(mean[1][s]).epsilon(0.05) );
+	}
+	// The peak at shift -3 must be found by both of them.
+	CHECK( std::max_element(mean[0].begin(), mean[0].end()) - mean[0].begin() == 2 );
+	CHECK( std::max_element(mean[1].begin(), mean[1].end()) - mean[1].begin() == 2 );
+}
+
+TEST_CASE( "Philox4x32-10 known answers", "[Philox4x32]" )
+{
+	// Known answer tests of Random123.
+	uint32_t output[4];
+	const uint32_t zero_counter[4] = {0, 0, 0, 0};
+	const uint32_t zero_key[2] = {0, 0};
+	Philox4x32::block(zero_counter, zero_key, output);
+	CHECK( output[0] == 0x6627e8d5u );
+	CHECK( output[1] == 0xe169c58du );
+	CHECK( output[2] == 0xbc57ac4cu );
+	CHECK( output[3] == 0x9b00dbd8u );
+	const uint32_t ones_counter[4] = {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu};
+	const uint32_t ones_key[2] = {0xffffffffu, 0xffffffffu};
+	Philox4x32::block(ones_counter, ones_key, output);
+	CHECK( output[0] == 0x408f276du );
+	CHECK( output[1] == 0x41c83b0eu );
+	CHECK( output[2] == 0xa20bc7c6u );
+	CHECK( output[3] == 0x6d5451fdu );
+}
+
+TEST_CASE( "Philox streams do not depend on the draws before them", "[Philox4x32]" )
+{
+	Philox4x32 fresh(99, -4);
+	fresh.seek(STREAM_REPETITION, 5);
+	std::vector<uint32_t> expected(10);
+	fresh.fill(expected.data(), expected.size());
+	Philox4x32 used(99, -4);
+	std::vector<uint32_t> skipped(13);
+	used.fill(skipped.data(), skipped.size());
+	used.seek(STREAM_REPETITION, 5);
+	std::vector<uint32_t> result(10);
+	for (uint32_t& value : result)
+	{
+		value = used();
+	}
+	CHECK( result == expected );
+	Philox4x32 other_shift(99, 4);
+	other_shift.seek(STREAM_REPETITION, 5);
+	CHECK( other_shift() != expected[0] );
+}
+
+TEST_CASE( "Seeded bootstrapping is reproducible", "[shifted_mutual_information_with_bootstrap]" )
+{
+	// Histogram indices, as in the MATLAB interface.
+	std::vector<uint8_t> X(3000);
+	std::vector<uint8_t> Y(3000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = uint8_t((i * 7919) % 101 % 8);
+		Y[i] = uint8_t((i * 104729) % 97 % 8);
+	}
+	for (int rng = 0; rng < 3; ++rng)
+	{
+		const BootstrapRng generator = static_cast<BootstrapRng>(rng);
+		std::vector<float> all(9 * 5);
+		shifted_mutual_information_with_bootstrap(-4, 4, 8, 8, 0.f, 100.f, 0.f, 100.f,
+			X.data(), X.data() + X.size(), Y.data(), Y.data() + Y.size(), 10, 5, 1, all.data(), generator, 12345);
+#ifdef _OPENMP
+		const int threads = omp_get_max_threads();
+		omp_set_num_threads(1);
+#endif
+		// Only the shifts 0, 2 and 4, on a single thread.
+		std::vector<float> some(3 * 5);
+		shifted_mutual_information_with_bootstrap(0, 4, 8, 8, 0.f, 100.f, 0.f, 100.f,
+			X.data(), X.data() + X.size(), Y.data(), Y.data() + Y.size(), 10, 5, 2, some.data(), generator, 12345);
+#ifdef _OPENMP
+		omp_set_num_threads(threads);
+#endif
+		for (int s = 0; s < 3; ++s)
+		{
+			for (int r = 0; r < 5; ++r)
+			{
+				CHECK( some[s * 5 + r] == all[(4 + 2 * s) * 5 + r] );
+			}
+		}
+		std::vector<float> other_seed(9 * 5);
+		shifted_mutual_information_with_bootstrap(-4, 4, 8, 8, 0.f, 100.f, 0.f, 100.f,
+			X.data(), X.data() + X.size(), Y.data(), Y.data() + Y.size(), 10, 5, 1, other_seed.data(), generator, 54321);
+		CHECK( other_seed != all );
+	}
+}
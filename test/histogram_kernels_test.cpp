@@ -0,0 +1,126 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <climits>
+#include "../src/histogram_kernels.h"
+
+/**
+ * Compare a histogram kernel with a naive loop on a slowly varying random walk
+ * (many consecutive samples in the same bin) with some values out of range.
+ */
+template<typename Index, typename Count = int, typename Kernel>
+void check_kernel(Kernel kernel, int binsX, int binsY, std::size_t size, Index invalid)
+{
+	std::mt19937 rgen(42);
+	std::uniform_int_distribution<int> step(-2, 2);
+	std::vector<Index> X(size);
+	std::vector<Index> Y(size);
+	int x = 0, y = 0;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		x = std::min(std::max(x + step(rgen), 0), binsX - 1);
+		y = std::min(std::max(y + step(rgen), 0), binsY - 1);
+		X[i] = Index(x);
+		Y[i] = Index(y);
+		if (i % 97 == 5)
+			X[i] = invalid;
+		if (i % 89 == 3)
+			Y[i] = Index(binsY);
+	}
+	std::vector<Count> expected(binsX * binsY, 1);
+	std::size_t expected_count = 0;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		if (X[i] >= 0 && X[i] < binsX && Y[i] >= 0 && Y[i] < binsY)
+		{
+			++expected[X[i] * binsY + Y[i]];
+			++expected_count;
+		}
+	}
+	std::vector<int> scratch(histogram_kernel_scratch_size(binsX, binsY));
+	std::vector<Count> H(binsX * binsY, 1);
+	CHECK( kernel(H.data(), binsX, binsY, X.data(), Y.data(), size, scratch.data()) == expected_count );
+	CHECK( H == expected );
+}
+
+TEST_CASE( "Histogram kernels give the same counts as a naive loop", "[histogram_kernels]" )
+{
+	check_kernel<uint8_t>(increment_histogram_2d_scalar<int, uint8_t>, 10, 10, 10007, 255);
+	check_kernel<uint8_t>(increment_histogram_2d_scalar<int, uint8_t>, 3, 7, 5, 255);
+	check_kernel<int>(increment_histogram_2d_scalar<int, int>, 16, 16, 20011, -1);
+	check_kernel<long>(increment_histogram_2d_scalar<int, long>, 5, 5, 1000, -1);
+	// Dispatch to the best kernel available.
+	check_kernel<uint8_t>(increment_histogram_2d<int, uint8_t>, 10, 10, 10007, 255);
+	check_kernel<uint8_t>(increment_histogram_2d<int, uint8_t>, 1, 1, 999, 255);
+	check_kernel<uint16_t>(increment_histogram_2d<int, uint16_t>, 300, 20, 100003, 65535);
+	check_kernel<int>(increment_histogram_2d<int, int>, 16, 16, 20011, INT_MAX);
+	check_kernel<long>(increment_histogram_2d<int, long>, 5, 5, 1000, -1);
+	// 64-bit counters in the histogram itself.
+	check_kernel<uint8_t, long long>(increment_histogram_2d<long long, uint8_t>, 10, 10, 10007, 255);
+	check_kernel<int, long long>(increment_histogram_2d<long long, int>, 16, 16, 20011, -1);
+	CHECK( mask_popcount(0xFFFFu) == 16 );
+	CHECK( mask_popcount(0x8001u) == 2 );
+}
+
+TEST_CASE( "Histogram kernels for bin shapes known at compile time", "[histogram_kernels_fixed]" )
+{
+	check_kernel<uint8_t>([](int* H, int, int, const uint8_t* X, const uint8_t* Y, std::size_t size, int*)
+		{ return increment_histogram_2d_fixed<10, 10>(H, X, Y, size); }, 10, 10, 10007, 255);
+	check_kernel<uint8_t>([](int* H, int, int, const uint8_t* X, const uint8_t* Y, std::size_t size, int*)
+		{ return increment_histogram_2d_fixed<16, 8>(H, X, Y, size); }, 16, 8, 7, 255);
+	check_kernel<int, long long>([](long long* H, int, int, const int* X, const int* Y, std::size_t size, int*)
+		{ return increment_histogram_2d_fixed<32, 32>(H, X, Y, size); }, 32, 32, 70001, -1);
+	// Shapes with and without a kernel of their own.
+	check_kernel<uint16_t>(increment_histogram_2d_portable<int, uint16_t>, 8, 16, 20011, 65535);
+	check_kernel<uint16_t>(increment_histogram_2d_portable<int, uint16_t>, 9, 16, 20011, 65535);
+	check_kernel<uint16_t>(increment_histogram_2d_portable<int, uint16_t>, 64, 64, 70001, 65535);
+	// Index types without vector kernels always take the scalar fallback.
+	check_kernel<long>(increment_histogram_2d<int, long>, 32, 32, 30011, -1);
+	std::size_t inserted = 0;
+	std::vector<int> H(6 * 6);
+	std::vector<uint8_t> X(10, 1);
+	CHECK_FALSE( increment_histogram_2d_fixed_shapes(H.data(), 6, 6, X.data(), X.data(), X.size(), inserted,
+		histogram_kernel_fixed_shapes()) );
+}
+
+#if defined(__AVX2__)
+TEST_CASE( "AVX2 histogram kernel", "[histogram_kernels_avx2]" )
+{
+	check_kernel<uint8_t>(increment_histogram_2d_avx2<int, uint8_t>, 10, 10, 10007, 255);
+	check_kernel<uint8_t>(increment_histogram_2d_avx2<int, uint8_t>, 3, 7, 5, 255);
+	check_kernel<uint16_t>(increment_histogram_2d_avx2<int, uint16_t>, 300, 20, 100003, 65535);
+	check_kernel<int>(increment_histogram_2d_avx2<int, int>, 16, 16, 20011, INT_MAX);
+	check_kernel<int>(increment_histogram_2d_avx2<int, int>, 16, 16, 20011, -1);
+}
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+TEST_CASE( "AVX-512 histogram kernel", "[histogram_kernels_avx512]" )
+{
+	check_kernel<uint8_t>(increment_histogram_2d_avx512<int, uint8_t>, 10, 10, 10007, 255);
+	check_kernel<uint8_t>(increment_histogram_2d_avx512<int, uint8_t>, 3, 7, 5, 255);
+	check_kernel<uint16_t>(increment_histogram_2d_avx512<int, uint16_t>, 300, 20, 100003, 65535);
+	check_kernel<int>(increment_histogram_2d_avx512<int, int>, 16, 16, 20011, INT_MAX);
+	check_kernel<int>(increment_histogram_2d_avx512<int, int>, 16, 16, 20011, -1);
+}
+#endif
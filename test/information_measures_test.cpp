@@ -0,0 +1,91 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include "../src/utilities.h"
+#include "../src/information_measures.h"
+
+TEST_CASE( "Entropies of a histogram", "[Histogram2d_entropies]" )
+{
+	// X is uniform over 4 bins and Y equals X modulo 2.
+	Histogram2d<double> hist(4, 2, 0., 1., 0., 1.);
+	for (int x = 0; x < 4; ++x)
+	{
+		hist.increment_at(x, x % 2);
+	}
+	double entropies[3];
+	hist.calculate_entropies(entropies);
+	CHECK( entropies[0] == Approx(2.) );
+	CHECK( entropies[1] == Approx(1.) );
+	CHECK( entropies[2] == Approx(2.) );
+	CHECK( *hist.calculate_mutual_information() == Approx(1.) );
+}
+
+TEST_CASE( "All engines give the same entropies", "[shifted_mutual_information_entropies]" )
+{
+	std::vector<uint8_t> X(4001);
+	std::vector<uint8_t> Y(4001);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = uint8_t((i * 5 + i / 17) % 6);
+		Y[i] = uint8_t((i * 3 + i / 7) % 4);
+	}
+	const int nr_shifts = 2 * 30 / 4 + 1;
+	std::vector<double> expected_mi(nr_shifts);
+	std::vector<double> expected_raw(nr_shifts);
+	std::vector<double> expected(3 * nr_shifts);
+	shifted_mutual_information_per_shift(-30, 30, 6, 4, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), 4, expected_mi.data(), BIAS_NONE, expected_raw.data(), expected.data());
+	for (int s = 0; s < nr_shifts; ++s)
+	{
+		REQUIRE( expected[3 * s] + expected[3 * s + 1] - expected[3 * s + 2] == Approx(expected_mi[s]) );
+	}
+	for (ShiftEngine engine : {ENGINE_TILED, ENGINE_FFT, ENGINE_BITPLANE})
+	{
+		std::vector<double> mi(nr_shifts);
+		std::vector<double> raw(nr_shifts);
+		std::vector<double> entropies(3 * nr_shifts);
+		shifted_mutual_information(-30, 30, 6, 4, 0., 1., 0., 1., X.data(), X.data() + X.size(),
+			Y.data(), Y.data() + Y.size(), 4, mi.data(), engine, BIAS_NONE, raw.data(), entropies.data());
+		for (int i = 0; i < 3 * nr_shifts; ++i)
+		{
+			REQUIRE( entropies[i] == Approx(expected[i]) );
+		}
+	}
+}
+
+TEST_CASE( "Measures derived from mutual information and entropies", "[information_measure]" )
+{
+	const std::vector<float> mi {1.f, 0.f};
+	const std::vector<float> entropies {2.f, 1.f, 2.f, 0.f, 3.f, 3.f};
+	CHECK( information_measure(MEASURE_ENTROPY_X, mi, entropies) == std::vector<float>({2.f, 0.f}) );
+	CHECK( information_measure(MEASURE_ENTROPY_Y, mi, entropies) == std::vector<float>({1.f, 3.f}) );
+	CHECK( information_measure(MEASURE_JOINT_ENTROPY, mi, entropies) == std::vector<float>({2.f, 3.f}) );
+	CHECK( information_measure(MEASURE_NMI_X, mi, entropies) == std::vector<float>({0.5f, 0.f}) );
+	CHECK( information_measure(MEASURE_NMI_Y, mi, entropies) == std::vector<float>({1.f, 0.f}) );
+	CHECK( information_measure(MEASURE_NMI_SQRT, mi, entropies)[0] == Approx(1. / std::sqrt(2.)) );
+	CHECK( information_measure(MEASURE_NMI_JOINT, mi, entropies) == std::vector<float>({0.5f, 0.f}) );
+	CHECK( information_measure(MEASURE_VARIATION, mi, entropies) == std::vector<float>({1.f, 3.f}) );
+	CHECK_THROWS_AS( information_measure(MEASURE_NMI_X, mi, std::vector<float>(3)), std::logic_error& );
+	CHECK( information_measure_names().size() == MEASURE_VARIATION + 1 );
+	CHECK( information_measure_from_name("variation") == MEASURE_VARIATION );
+	CHECK_THROWS_AS( information_measure_from_name("nmi"), std::invalid_argument& );
+}
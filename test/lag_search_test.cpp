@@ -0,0 +1,91 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include "../src/lag_search.h"
+
+TEST_CASE( "Lag search finds the maxima of the full scan", "[find_mutual_information_peaks]" )
+{
+	// Smooth noise so that the peaks are a few shifts wide like in recordings.
+	// Y is X delayed by 337 samples plus a weaker copy delayed by -1210 samples.
+	const std::size_t size = 20000;
+	std::vector<float> white(size + 4000 + 16);
+	unsigned state = 12345;
+	for (float& value : white)
+	{
+		state = state * 1103515245u + 12345u;
+		value = float((state >> 8) & 0xffff) / 65536.f;
+	}
+	std::vector<float> noise(size + 4000);
+	for (std::size_t k = 0; k < noise.size(); ++k)
+	{
+		noise[k] = std::accumulate(white.begin() + k, white.begin() + k + 16, 0.f) / 16.f;
+	}
+	std::vector<float> X(noise.begin() + 2000, noise.begin() + 2000 + size);
+	std::vector<float> Y(size);
+	for (std::size_t k = 0; k < size; ++k)
+	{
+		Y[k] = noise[2000 + k + 337] + 0.5f * noise[2000 + k - 1210];
+	}
+	auto minmaxY = std::minmax_element(Y.begin(), Y.end());
+	auto minmaxX = std::minmax_element(X.begin(), X.end());
+	auto full = shifted_mutual_information(-1500, 1500, 8, 8, *minmaxX.first, *minmaxX.second, *minmaxY.first, *minmaxY.second,
+		X.begin(), X.end(), Y.begin(), Y.end());
+	const int best = int(std::max_element(full.begin(), full.end()) - full.begin()) - 1500;
+	auto result = find_mutual_information_peaks(-1500, 1500, 8, 8, *minmaxX.first, *minmaxX.second, *minmaxY.first, *minmaxY.second,
+		X.begin(), X.end(), Y.begin(), Y.end(), 3, 10);
+	REQUIRE( result.peaks.size() >= 2 );
+	REQUIRE( result.peaks.size() <= 3 );
+	CHECK( result.peaks[0].shift == best );
+	CHECK( result.peaks[0].mutual_information == Approx(full[best + 1500]) );
+	CHECK( result.peaks[1].mutual_information <= result.peaks[0].mutual_information );
+	// The peaks are local maxima of the full scan.
+	for (const LagPeak<float>& peak : result.peaks)
+	{
+		const int k = peak.shift + 1500;
+		CHECK( full[k] >= full[std::max(k - 1, 0)] );
+		CHECK( full[k] >= full[std::min(k + 1, 3000)] );
+	}
+	// Far fewer evaluations than shifts.
+	REQUIRE( result.shifts.size() == result.values.size() );
+	CHECK( result.shifts.size() < full.size() / 3 );
+	CHECK( std::is_sorted(result.shifts.begin(), result.shifts.end()) );
+	for (std::size_t i = 0; i < result.shifts.size(); ++i)
+	{
+		CHECK( result.values[i] == Approx(full[result.shifts[i] + 1500]) );
+	}
+	CHECK( result.shifts.front() == -1500 );
+	CHECK( result.shifts.back() == 1500 );
+}
+
+TEST_CASE( "Lag search checks its arguments", "[find_mutual_information_peaks_errors]" )
+{
+	std::vector<float> X {0.f, 1.f, 2.f, 3.f, 4.f, 5.f};
+	CHECK_THROWS_AS( find_mutual_information_peaks(-2, 2, 3, 3, 0.f, 5.f, 0.f, 5.f,
+		X.begin(), X.end(), X.begin(), X.end(), 0), std::invalid_argument& );
+	CHECK_THROWS_AS( find_mutual_information_peaks(-2, 2, 3, 3, 0.f, 5.f, 0.f, 5.f,
+		X.begin(), X.end(), X.begin(), X.end(), 1, -1), std::invalid_argument& );
+	auto result = find_mutual_information_peaks(-2, 2, 3, 3, 0.f, 5.f, 0.f, 5.f,
+		X.begin(), X.end(), X.begin(), X.end(), 1, 10);
+	REQUIRE( result.peaks.size() == 1 );
+	CHECK( result.peaks[0].shift == 0 );
+}
@@ -0,0 +1,60 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include "../src/utilities.h"
+
+TEST_CASE( "NUMA policies by name", "[numa_policy_from_name]" )
+{
+	CHECK( numa_policy_from_name("none") == NUMA_NONE );
+	CHECK( numa_policy_from_name("interleave") == NUMA_INTERLEAVE );
+	CHECK( numa_policy_from_name("replicate") == NUMA_REPLICATE );
+	CHECK_THROWS_AS( numa_policy_from_name("everywhere"), std::invalid_argument& );
+	CHECK( numa_node_count() >= 1 );
+}
+
+TEST_CASE( "NumaArray holds a copy", "[NumaArray]" )
+{
+	std::vector<int> data {4, 8, 15, 16, 23, 42};
+	const NumaArray<int> interleaved(data.data(), data.size(), numa_interleaved);
+	const NumaArray<int> local(data.data(), data.size(), 0);
+	REQUIRE( interleaved.size() == data.size() );
+	CHECK( std::vector<int>(interleaved.data(), interleaved.data() + data.size()) == data );
+	CHECK( std::vector<int>(local.data(), local.data() + data.size()) == data );
+}
+
+TEST_CASE( "NUMA policies do not change the results", "[shifted_mutual_information_numa]" )
+{
+	std::vector<float> X(5000);
+	std::vector<float> Y(5000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = std::sin(0.01f * i);
+		Y[i] = std::cos(0.013f * i);
+	}
+	auto none = shifted_mutual_information(-50, 50, 8, 8, -1.f, 1.f, -1.f, 1.f,
+		X.begin(), X.end(), Y.begin(), Y.end(), 3, ENGINE_AUTO, NUMA_NONE);
+	auto interleave = shifted_mutual_information(-50, 50, 8, 8, -1.f, 1.f, -1.f, 1.f,
+		X.begin(), X.end(), Y.begin(), Y.end(), 3, ENGINE_AUTO, NUMA_INTERLEAVE);
+	auto replicate = shifted_mutual_information(-50, 50, 8, 8, -1.f, 1.f, -1.f, 1.f,
+		X.begin(), X.end(), Y.begin(), Y.end(), 3, ENGINE_PER_SHIFT, NUMA_REPLICATE);
+	CHECK( interleave == none );
+	CHECK( replicate == none );
+}
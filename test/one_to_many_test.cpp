@@ -0,0 +1,134 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "../src/one_to_many.h"
+
+TEST_CASE( "One to many gives the same results as single pairs", "[one_to_many_shifted_mutual_information]" )
+{
+	const std::size_t size = 40000;
+	std::vector<float> reference(size);
+	std::vector< std::vector<float> > targets(7, std::vector<float>(size));
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		reference[i] = std::sin(0.001f * i) + 0.2f * std::cos(0.3f * i);
+		for (std::size_t t = 0; t < targets.size(); ++t)
+		{
+			targets[t][i] = std::sin(0.001f * (i + 30 * t)) + 0.1f * t * std::sin(0.77f * i);
+		}
+	}
+	auto minmax = std::minmax_element(reference.begin(), reference.end());
+	const int nr_shifts = 20;
+	auto matrix = one_to_many_shifted_mutual_information(-40, 55, 12, 300,
+		*minmax.first, *minmax.second, reference.begin(), reference.end(),
+		targets, std::vector<float>(), std::vector<float>(), 5);
+	REQUIRE( matrix.size() == targets.size() * nr_shifts );
+	for (std::size_t t = 0; t < targets.size(); ++t)
+	{
+		auto minmaxY = std::minmax_element(targets[t].begin(), targets[t].end());
+		auto expected = shifted_mutual_information(-40, 55, 12, 300,
+			*minmax.first, *minmax.second, *minmaxY.first, *minmaxY.second,
+			reference.begin(), reference.end(), targets[t].begin(), targets[t].end(), 5);
+		for (int k = 0; k < nr_shifts; ++k)
+		{
+			CHECK( matrix[t * nr_shifts + k] == Approx(expected[k]) );
+		}
+	}
+}
+
+TEST_CASE( "One to many loads the targets in batches", "[one_to_many_shifted_mutual_information_streamed]" )
+{
+	const std::size_t size = 3000;
+	const std::size_t nr_targets = one_to_many_batch_targets + 3;
+	std::vector<float> reference(size);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		reference[i] = std::sin(0.01f * i);
+	}
+	const int nr_shifts = 11;
+	std::vector<std::size_t> loaded;
+	std::vector<std::size_t> stored;
+	std::vector<float> matrix(nr_targets * nr_shifts);
+	one_to_many_shifted_mutual_information_streamed(-5, 5, 8, 8, -1.f, 1.f, reference.begin(), reference.end(),
+		nr_targets,
+		[&](const std::size_t t, float& minY, float& maxY) -> std::vector<float>
+		{
+			loaded.push_back(t);
+			std::vector<float> target(size);
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				target[i] = std::sin(0.01f * (i + t));
+			}
+			minY = -1.f;
+			maxY = 1.f;
+			return target;
+		},
+		[&](const std::size_t first, const std::size_t last, const float* rows)
+		{
+			stored.push_back(first);
+			stored.push_back(last);
+			std::copy(rows, rows + (last - first) * nr_shifts, matrix.begin() + first * nr_shifts);
+		});
+	REQUIRE( loaded.size() == nr_targets );
+	for (std::size_t t = 0; t < nr_targets; ++t)
+	{
+		CHECK( loaded[t] == t );
+	}
+	REQUIRE( stored.size() == 4 );
+	CHECK( stored[0] == 0 );
+	CHECK( stored[1] == one_to_many_batch_targets );
+	CHECK( stored[2] == one_to_many_batch_targets );
+	CHECK( stored[3] == nr_targets );
+	for (std::size_t t : {std::size_t(0), nr_targets - 1})
+	{
+		std::vector<float> target(size);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			target[i] = std::sin(0.01f * (i + t));
+		}
+		auto expected = shifted_mutual_information(-5, 5, 8, 8, -1.f, 1.f, -1.f, 1.f,
+			reference.begin(), reference.end(), target.begin(), target.end());
+		for (int k = 0; k < nr_shifts; ++k)
+		{
+			CHECK( matrix[t * nr_shifts + k] == Approx(expected[k]) );
+		}
+	}
+}
+
+TEST_CASE( "One to many checks its arguments", "[one_to_many_shifted_mutual_information_errors]" )
+{
+	std::vector<float> reference {0.f, 1.f, 2.f, 3.f, 4.f, 5.f};
+	std::vector< std::vector<float> > targets {{0.f, 1.f, 2.f, 3.f, 4.f, 5.f}, {1.f, 1.f, 1.f, 1.f, 1.f, 1.f}};
+	auto single = one_to_many_shifted_mutual_information(-2, 2, 3, 3, 0.f, 5.f,
+		reference.begin(), reference.end(), targets, std::vector<float>(2, 0.f), std::vector<float>(2, 5.f));
+	CHECK( single.size() == 10 );
+	// Constant target without range.
+	CHECK_THROWS_AS( one_to_many_shifted_mutual_information(-2, 2, 3, 3, 0.f, 5.f,
+		reference.begin(), reference.end(), targets), std::logic_error& );
+	CHECK_THROWS_AS( one_to_many_shifted_mutual_information(-2, 2, 3, 3, 0.f, 5.f,
+		reference.begin(), reference.end(), targets, std::vector<float>(1, 0.f)), std::invalid_argument& );
+	targets[0].pop_back();
+	CHECK_THROWS_AS( one_to_many_shifted_mutual_information(-2, 2, 3, 3, 0.f, 5.f,
+		reference.begin(), reference.end(), targets, std::vector<float>(2, 0.f), std::vector<float>(2, 5.f)),
+		std::logic_error& );
+	CHECK_THROWS_AS( one_to_many_shifted_mutual_information(-2, 2, 3, 3, 0.f, 5.f,
+		reference.begin(), reference.end(), std::vector< std::vector<float> >()), std::invalid_argument& );
+}
@@ -0,0 +1,64 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include "../src/SimpleBinaryFile.h"
+#include "../src/SimpleCSV.h"
+#include "../src/out_of_core.h"
+
+TEST_CASE( "Chunked processing gives the same results as the whole data", "[shifted_mutual_information_chunked]" )
+{
+	std::vector<float> X(20000);
+	std::vector<float> Y(20000);
+	for (std::size_t i = 0; i < X.size(); ++i)
+	{
+		X[i] = std::sin(0.002f * i) + 0.1f * std::sin(0.9f * i);
+		Y[i] = std::cos(0.0031f * i);
+	}
+	SimpleBinaryFile<float> fileX("test/out_of_core_gen_x.bin", PREC_32);
+	SimpleBinaryFile<float> fileY("test/out_of_core_gen_y.bin", PREC_32);
+	fileX.writeData(X);
+	fileY.writeData(Y);
+	auto minmaxX = find_minmax_chunked(fileX, 777);
+	auto minmaxY = find_minmax_chunked(fileY, 777);
+	REQUIRE( minmaxX.first == *std::min_element(X.begin(), X.end()) );
+	REQUIRE( minmaxX.second == *std::max_element(X.begin(), X.end()) );
+	REQUIRE( minmaxY.second == *std::max_element(Y.begin(), Y.end()) );
+	auto expected = shifted_mutual_information(-700, 900, 20, 12,
+		minmaxX.first, minmaxX.second, minmaxY.first, minmaxY.second,
+		X.begin(), X.end(), Y.begin(), Y.end(), 7);
+	// A budget which allows only a few thousand samples per chunk.
+	const std::size_t budget = 1500000;
+	const std::size_t chunk_size = chunk_size_for_budget<float, uint8_t>(budget, 229, 20, 12, 900);
+	REQUIRE( chunk_size < X.size() / 3 );
+	auto chunked = shifted_mutual_information_chunked(fileX, fileY, -700, 900, 20, 12,
+		minmaxX.first, minmaxX.second, minmaxY.first, minmaxY.second, 7, budget);
+	CHECK( chunked == expected );
+	CHECK_THROWS_AS( shifted_mutual_information_chunked(fileX, fileY, -700, 900, 20, 12,
+		minmaxX.first, minmaxX.second, minmaxY.first, minmaxY.second, 7, 1000), std::invalid_argument& );
+}
+
+TEST_CASE( "Chunked processing needs files of the same size", "[shifted_mutual_information_chunked_sizes]" )
+{
+	SimpleCSV<float> fileX("test/SimpleCSV_random1.csv");
+	SimpleCSV<float> fileY("test/SimpleCSV_data1.csv");
+	CHECK_THROWS_AS( shifted_mutual_information_chunked(fileX, fileY, -1, 1, 4, 4,
+		0.f, 1.f, 0.f, 1.f, 1, 1000000), std::logic_error& );
+}
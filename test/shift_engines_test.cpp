@@ -0,0 +1,237 @@
+/**
+* Copyright 2018, University of Freiburg
+* Optophysiology Lab.
+* Thomas Leyh <thomas.leyh@mailbox.org>
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <catch.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../src/utilities.h"
+
+/**
+ * Indices of two noisy, slowly varying signals with a few values out of range.
+ */
+template<typename Index>
+void make_indices(std::vector<Index>& X, std::vector<Index>& Y, std::size_t size, int binsX, int binsY)
+{
+	std::vector<float> dataX(size);
+	std::vector<float> dataY(size);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		dataX[i] = std::sin(0.001f * i) + 0.2f * std::sin(0.37f * i);
+		dataY[i] = std::cos(0.0013f * i) * std::sin(0.05f * i);
+	}
+	dataX[size / 3] = NAN;
+	dataY[size / 2] = 2.f;
+	X = calculate_indices_1d<Index>(binsX, -1.2f, 1.2f, dataX.begin(), dataX.end());
+	Y = calculate_indices_1d<Index>(binsY, -1.f, 1.f, dataY.begin(), dataY.end());
+}
+
+TEST_CASE( "Tiled engine gives the same results as the per-shift engine", "[shifted_mutual_information_tiled]" )
+{
+	std::vector<uint8_t> X, Y;
+	make_indices(X, Y, 100000, 12, 9);
+	// Neither the number of shifts nor the data size are multiples of block or chunk sizes.
+	const int shift_from = -1234;
+	const int shift_to = 987;
+	const int step = 13;
+	const int nr_shifts = (shift_to - shift_from) / step + 1;
+	std::vector<double> per_shift(nr_shifts);
+	std::vector<double> tiled(nr_shifts);
+	shifted_mutual_information_per_shift(shift_from, shift_to, 12, 9, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, per_shift.data());
+	shifted_mutual_information_tiled(shift_from, shift_to, 12, 9, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, tiled.data());
+	for (int i = 0; i < nr_shifts; ++i)
+	{
+		REQUIRE( tiled[i] == per_shift[i] );
+	}
+	// Also through the public interface.
+	std::vector<double> result(nr_shifts);
+	shifted_mutual_information(shift_from, shift_to, 12, 9, 0., 1., 0., 1.,
+		X.data(), X.data() + X.size(), Y.data(), Y.data() + Y.size(), step, result.data(), ENGINE_TILED);
+	CHECK( result == per_shift );
+}
+
+TEST_CASE( "Tiled engine with shifts as large as the data", "[shifted_mutual_information_tiled_edges]" )
+{
+	std::vector<int> X, Y;
+	make_indices(X, Y, 300, 4, 4);
+	std::vector<float> per_shift(599);
+	std::vector<float> tiled(599);
+	shifted_mutual_information_per_shift(-299, 299, 4, 4, 0.f, 1.f, 0.f, 1.f,
+		X.data(), Y.data(), X.size(), 1, per_shift.data());
+	shifted_mutual_information_tiled(-299, 299, 4, 4, 0.f, 1.f, 0.f, 1.f,
+		X.data(), Y.data(), X.size(), 1, tiled.data());
+	CHECK( tiled == per_shift );
+}
+
+TEST_CASE( "FFT engine gives the same results as the per-shift engine", "[shifted_mutual_information_fft]" )
+{
+	std::vector<uint16_t> X, Y;
+	// Odd number of bins so one X and one Y transform hold a single bin.
+	make_indices(X, Y, 20000, 7, 5);
+	const int shift_from = -19999;
+	const int shift_to = 19990;
+	const int step = 7;
+	const int nr_shifts = (shift_to - shift_from) / step + 1;
+	std::vector<double> per_shift(nr_shifts);
+	std::vector<double> fft(nr_shifts);
+	shifted_mutual_information_per_shift(shift_from, shift_to, 7, 5, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, per_shift.data());
+	shifted_mutual_information_fft(shift_from, shift_to, 7, 5, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, fft.data());
+	for (int i = 0; i < nr_shifts; ++i)
+	{
+		REQUIRE( fft[i] == per_shift[i] );
+	}
+}
+
+TEST_CASE( "FFT engine with unused bins", "[shifted_mutual_information_fft_unused]" )
+{
+	std::vector<int> X {0, 0, 3, 3, 0, 3, 3, 0, 9, 0};
+	std::vector<int> Y {1, 1, 1, 0, 0, 0, 1, 1, 1, 0};
+	std::vector<float> per_shift(7);
+	std::vector<float> fft(7);
+	shifted_mutual_information_per_shift(-3, 3, 4, 3, 0.f, 1.f, 0.f, 1.f,
+		X.data(), Y.data(), X.size(), 1, per_shift.data());
+	shifted_mutual_information(-3, 3, 4, 3, 0.f, 1.f, 0.f, 1.f,
+		X.data(), X.data() + X.size(), Y.data(), Y.data() + Y.size(), 1, fft.data(), ENGINE_FFT);
+	CHECK( fft == per_shift );
+}
+
+TEST_CASE( "Automatic choice of the engine", "[choose_shift_engine]" )
+{
+	CHECK( choose_shift_engine(1, 1000, 20, 20, 0) == ENGINE_PER_SHIFT );
+	CHECK( choose_shift_engine(200, 2000000, 20, 20, 100) == ENGINE_TILED );
+	CHECK( choose_shift_engine(100, 1000000, 2, 2, 50) == ENGINE_BITPLANE );
+	CHECK( choose_shift_engine(200001, 100000, 10, 10, 100000) == ENGINE_FFT );
+	// Many bins make the FFT engine expensive.
+	CHECK( choose_shift_engine(4001, 2000000, 200, 200, 2000) != ENGINE_FFT );
+	// It would be fast, but the counts of all shifts alone take 3.3 GB.
+	CHECK( fft_engine_bytes(200001, 1000000, 64, 64, 100000) > 3e9 );
+	CHECK( choose_shift_engine(200001, 1000000, 64, 64, 100000) != ENGINE_FFT );
+}
+
+TEST_CASE( "Bitplane engine gives the same results as the per-shift engine", "[shifted_mutual_information_bitplane]" )
+{
+	// Sizes which are no multiples of 64, up to the largest number of bins.
+	const int bins[][2] {{2, 2}, {4, 3}, {16, 16}};
+	for (const auto& b : bins)
+	{
+		std::vector<uint8_t> X, Y;
+		make_indices(X, Y, 70001, b[0], b[1]);
+		const int shift_from = -70000;
+		const int shift_to = 69999;
+		const int step = 97;
+		const int nr_shifts = (shift_to - shift_from) / step + 1;
+		std::vector<double> per_shift(nr_shifts);
+		std::vector<double> bitplane(nr_shifts);
+		shifted_mutual_information_per_shift(shift_from, shift_to, b[0], b[1], 0., 1., 0., 1.,
+			X.data(), Y.data(), X.size(), step, per_shift.data());
+		shifted_mutual_information_bitplane(shift_from, shift_to, b[0], b[1], 0., 1., 0., 1.,
+			X.data(), Y.data(), X.size(), step, bitplane.data());
+		CHECK( bitplane == per_shift );
+	}
+	std::vector<float> output(3);
+	std::vector<int> X(100, 0);
+	CHECK_THROWS_AS( shifted_mutual_information_bitplane(-1, 1, 17, 2, 0.f, 1.f, 0.f, 1.f,
+		X.data(), X.data(), X.size(), 1, output.data()), std::invalid_argument& );
+}
+
+TEST_CASE( "Splitting few shifts into chunks", "[chunks_per_shift]" )
+{
+	CHECK( chunks_per_shift(64, 100000000, 64) == 1 );
+	CHECK( chunks_per_shift(5, 500000000, 64) == 13 );
+	CHECK( chunks_per_shift(1, 100000, 64) == 1 );
+	CHECK( chunks_per_shift(1, 3 * split_shift_min_samples, 8) == 3 );
+	CHECK( chunks_per_shift(3, 1000000000, 1) == 1 );
+}
+
+TEST_CASE( "Engines split few shifts across threads", "[shifted_mutual_information_split]" )
+{
+	std::vector<uint8_t> X, Y;
+	make_indices(X, Y, 8 * split_shift_min_samples + 13, 6, 5);
+	const int shift_from = -3;
+	const int shift_to = 5;
+	const int step = 4;
+#ifdef _OPENMP
+	// The reference is calculated on a single thread, so every shift is one chunk.
+	const int nr_threads = omp_get_max_threads();
+	omp_set_num_threads(1);
+	REQUIRE( chunks_per_shift(3, X.size(), shift_engine_threads()) == 1 );
+#endif
+	std::vector<double> single(3);
+	shifted_mutual_information_per_shift(shift_from, shift_to, 6, 5, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, single.data());
+#ifdef _OPENMP
+	// Pretend there are more threads than shifts (also with a single core).
+	omp_set_num_threads(7);
+	REQUIRE( chunks_per_shift(3, X.size(), shift_engine_threads()) == 3 );
+#endif
+	std::vector<double> per_shift(3);
+	std::vector<double> bitplane(3);
+	shifted_mutual_information_per_shift(shift_from, shift_to, 6, 5, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, per_shift.data());
+	shifted_mutual_information_bitplane(shift_from, shift_to, 6, 5, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, bitplane.data());
+#ifdef _OPENMP
+	omp_set_num_threads(nr_threads);
+#endif
+	CHECK( per_shift == single );
+	CHECK( bitplane == single );
+}
+
+TEST_CASE( "Engines with 64-bit counts give the same results", "[shifted_mutual_information_wide_counts]" )
+{
+	std::vector<uint8_t> X, Y;
+	make_indices(X, Y, 30011, 10, 7);
+	const int shift_from = -321;
+	const int shift_to = 400;
+	const int step = 9;
+	const int nr_shifts = (shift_to - shift_from) / step + 1;
+	REQUIRE( !needs_wide_counts(X.size()) );
+	REQUIRE( needs_wide_counts(std::size_t(std::numeric_limits<int>::max()) + 1) );
+	std::vector<double> expected(nr_shifts);
+	shifted_mutual_information_per_shift(shift_from, shift_to, 10, 7, 0., 1., 0., 1.,
+		X.data(), Y.data(), X.size(), step, expected.data());
+	std::vector<double> per_shift(nr_shifts);
+	std::vector<double> tiled(nr_shifts);
+	std::vector<double> fft(nr_shifts);
+	std::vector<double> bitplane(nr_shifts);
+	shifted_mutual_information_per_shift<double, uint8_t, long long>(shift_from, shift_to, 10, 7,
+		0., 1., 0., 1., X.data(), Y.data(), X.size(), step, per_shift.data());
+	shifted_mutual_information_tiled<double, uint8_t, long long>(shift_from, shift_to, 10, 7,
+		0., 1., 0., 1., X.data(), Y.data(), X.size(), step, tiled.data());
+	shifted_mutual_information_fft<double, uint8_t, long long>(shift_from, shift_to, 10, 7,
+		0., 1., 0., 1., X.data(), Y.data(), X.size(), step, fft.data());
+	shifted_mutual_information_bitplane<double, uint8_t, long long>(shift_from, shift_to, 10, 7,
+		0., 1., 0., 1., X.data(), Y.data(), X.size(), step, bitplane.data());
+	// The counts are the same, but with fused multiply-adds (-march=native)
+	// the sums of the table lookups may round differently.
+	for (int i = 0; i < nr_shifts; ++i)
+	{
+		REQUIRE( per_shift[i] == Approx(expected[i]).epsilon(1e-12) );
+		REQUIRE( tiled[i] == Approx(expected[i]).epsilon(1e-12) );
+		REQUIRE( bitplane[i] == Approx(expected[i]).epsilon(1e-12) );
+		REQUIRE( fft[i] == Approx(expected[i]) );
+	}
+}
@@ -18,4 +18,5 @@
 
 #define CATCH_CONFIG_MAIN
 #define CATCH_CONFIG_COLOUR_NONE
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 #include <catch.hpp>
@@ -20,6 +20,7 @@
 #include <cmath>
 #include <climits>
 #include <algorithm>
+#include <cstdint>
 #include "../src/utilities.h"
 
 TEST_CASE( "Test calculation of indices in 1 dimension.", "[calculate_indices_1d]" )
@@ -71,6 +72,42 @@ TEST_CASE( "Test calculation of indices in 2 dimensions.", "[calculate_indices_2
 	CHECK( indices[799].second == 9 );
 }
 
+TEST_CASE( "Test calculation of narrow indices.", "[calculate_indices_narrow]" )
+{
+	std::vector<float> input(1000);
+	for (int i = 0; i < 1000; ++i)
+	{
+		input[i] = float(i) - 500.f;
+	}
+	input[123] = NAN;
+	auto indices = calculate_indices_1d<uint8_t>(10, -500.f, 499.f, input.begin(), input.end());
+	auto wide = calculate_indices_1d(10, -500.f, 499.f, input.begin(), input.end());
+	REQUIRE( indices.size() == 1000 );
+	CHECK( indices[123] == 255 );
+	CHECK( indices[123] == index_sentinel<uint8_t>() );
+	for (int i = 0; i < 1000; ++i)
+	{
+		if (i != 123)
+			CHECK( int(indices[i]) == wide[i] );
+	}
+	auto indices16 = calculate_indices_1d<uint16_t>(1000, -500.f, 499.f, input.begin(), input.end());
+	CHECK( indices16[999] == 999 );
+	CHECK( indices16[123] == 65535 );
+	CHECK_THROWS( calculate_indices_1d<uint8_t>(255, -500.f, 499.f, input.begin(), input.end()) );
+	CHECK_NOTHROW( calculate_indices_1d<uint8_t>(254, -500.f, 499.f, input.begin(), input.end()) );
+	auto pairs = calculate_indices_2d<uint8_t>(10, 20, -500.f, 499.f, -500.f, 499.f,
+			input.begin(), input.end(), input.begin(), input.end());
+	CHECK( sizeof(pairs[0]) == 2 );
+	CHECK( pairs[999].first == 9 );
+	CHECK( pairs[999].second == 19 );
+	CHECK( pairs[123].first == 255 );
+	CHECK( pairs[123].second == 255 );
+	CHECK( index_width(10) == 1 );
+	CHECK( index_width(254) == 1 );
+	CHECK( index_width(255) == 2 );
+	CHECK( index_width(65535) == 4 );
+}
+
 TEST_CASE( "Shifted mutual information on sinoid data." "[shifted_mutual_information]")
 {
 	// Fill a vector with sinoid data.
@@ -110,6 +147,16 @@ TEST_CASE( "Shifted mutual information on sinoid data." "[shifted_mutual_informa
 	{
 		CHECK( array_result[i] == result[i] );
 	}
+
+	// Narrow indices for the same data must give the same result.
+	auto narrow = calculate_indices_1d<uint8_t>(10, -1.f, 1.f, data.begin(), data.end());
+	const uint8_t* narrow_ptr = narrow.data();
+	shifted_mutual_information(-100, 100, 10, 10, -1.f, 1.f, -1.f, 1.f,
+							   narrow_ptr, narrow_ptr + 1000, narrow_ptr, narrow_ptr + 1000, 1, array_result);
+	for (int i = 0; i < 201; ++i)
+	{
+		CHECK( array_result[i] == result[i] );
+	}
 }
 
 TEST_CASE( "Exact test on small set of triangle data." "[shifted_mutual_information_triangle]")
@@ -132,6 +179,32 @@ TEST_CASE( "Exact test on small set of triangle data." "[shifted_mutual_informat
 	CHECK( result[10] == Approx(0.954434f) );
 }
 
+TEST_CASE( "Reused per-thread histograms match fresh histograms per shift." "[shifted_mutual_information_from_indices]")
+{
+	std::vector<float> dataX(2000);
+	std::vector<float> dataY(2000);
+	float value = 0;
+	for (int i = 0; i < 2000; ++i)
+	{
+		dataX[i] = std::sin(value);
+		dataY[i] = std::cos(3.f * value);
+		value += 0.013f;
+	}
+	dataX[17] = NAN;
+	dataY[1500] = 5.f; // Outside of [min,max]
+	auto indicesX = calculate_indices_1d(8, -1.f, 1.f, dataX.begin(), dataX.end());
+	auto indicesY = calculate_indices_1d(6, -1.f, 1.f, dataY.begin(), dataY.end());
+	auto result = shifted_mutual_information(-300, 250, 8, 6, -1.f, 1.f, -1.f, 1.f,
+											 dataX.begin(), dataX.end(), dataY.begin(), dataY.end(), 7);
+	REQUIRE( result.size() == 79 );
+	for (int i = -300, r = 0; i <= 250; i += 7, ++r)
+	{
+		Histogram2d<float> hist(8, 6, -1.f, 1.f, -1.f, 1.f);
+		increment_shifted(hist, i, indicesX.begin(), indicesX.end(), indicesY.begin(), indicesY.end());
+		CHECK( result[r] == *hist.calculate_mutual_information() );
+	}
+}
+
 template<typename T, typename Iterator>
 inline T calc_mean(Iterator begin, Iterator end)
 {